@@ -6,11 +6,49 @@
 #include <algorithm>
 #include <stdexcept>
 #include <sstream>
+#include <memory_resource>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <map>
+#include <optional>
+#include <variant>
+#include <tuple>
+#include <type_traits>
+#include <deque>
+#include <list>
+#include <cstdint>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <cerrno>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include <string_view>
+#include <charconv>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
 
 // Forward declarations
 class Student;
 class Course;
 class Faculty;
+class EnrollmentIndex;
+class LazyStudentStore;
 
 // =====================================================================
 // MODULE 5: Exception Handling
@@ -24,503 +62,7895 @@ public:
 };
 
 // =====================================================================
-// MODULE 5: Template Class
-// A generic container to manage lists of any type of record (Student, Course, etc.)
+// Logging Subsystem
+// Levelled logging that keeps console I/O off the hot path:
+//  - UMS_LOG(level) << ... only evaluates (formats) its arguments when the
+//    level is enabled, so disabled messages cost a single comparison;
+//  - a message is formatted into a fixed-size slot (no heap allocation) and
+//    pushed into a lock-free ring buffer;
+//  - in asynchronous mode a background thread drains the ring and writes
+//    whole batches, flushing once per batch instead of once per line.
+// Until start_async() is called messages are written synchronously, which
+// keeps them in order with other console output (as in the main() demo).
 // =====================================================================
-template <typename T>
-class RecordList {
-private:
-    std::vector<T> records; // Internal storage for the array of objects
+enum class LogLevel : uint8_t { Debug = 0, Info = 1, Warn = 2, Error = 3, Off = 4 };
 
+class Logger {
 public:
-    // Demonstrates Function with Default Arguments
-    void add_record(const T& record, bool verbose = true) {
-        records.push_back(record);
-        if (verbose) {
-            std::cout << "[INFO] Record successfully added to the list." << std::endl;
+    static const size_t MESSAGE_CAPACITY = 240;
+
+private:
+    // Bounded multi-producer queue (Vyukov): each cell's sequence number tells
+    // producers and the consumer whose turn it is, so no locks are needed
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        uint16_t length;
+        char text[MESSAGE_CAPACITY];
+    };
+    static const size_t RING_SIZE = 4096; // Power of two
+
+    std::unique_ptr<Cell[]> ring;
+    std::atomic<size_t> enqueue_pos{0};
+    size_t dequeue_pos = 0; // Only touched by the drain thread
+    std::atomic<size_t> drained{0};
+
+    std::atomic<bool> async{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<int> producers{0}; // submit() calls currently on the asynchronous path
+    std::thread drainer;
+    std::mutex flush_mutex; // Pairs with 'drained_changed' for flush()
+    std::condition_variable drained_changed;
+    std::mutex sync_mutex; // Synchronous mode and start/stop
+
+    static std::atomic<int>& level_ref() {
+        static std::atomic<int> level(static_cast<int>(LogLevel::Info));
+        return level;
+    }
+
+    Logger() : ring(new Cell[RING_SIZE]) {
+        for (size_t i = 0; i < RING_SIZE; ++i) {
+            ring[i].sequence.store(i, std::memory_order_relaxed);
         }
     }
 
-    T* find_record(int id) {
-        for (T& record : records) {
-            // Note: Assumes T has a get_id() or equivalent method
-            if (record.get_id() == id) {
-                return &record;
+    static std::ostream& stream_for(LogLevel level) {
+        return level >= LogLevel::Warn ? std::cerr : std::cout;
+    }
+
+    bool try_enqueue(LogLevel level, const char* text, size_t length) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = ring[pos & (RING_SIZE - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.level = level;
+                    cell.length = static_cast<uint16_t>(length);
+                    std::memcpy(cell.text, text, length);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Ring is full
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
             }
         }
-        return nullptr;
     }
 
-    void display_all() const {
-        if (records.empty()) {
-            std::cout << "No records found." << std::endl;
-            return;
+    // Writes every message published so far; returns how many there were.
+    // Called by the drain thread, and by stop_async() once that has exited.
+    size_t drain_ready(std::string& out_batch, std::string& err_batch) {
+        size_t count = 0;
+        while (true) {
+            Cell& cell = ring[dequeue_pos & (RING_SIZE - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) break;
+            std::string& batch = cell.level >= LogLevel::Warn ? err_batch : out_batch;
+            batch.append(cell.text, cell.length);
+            batch.push_back('\n');
+            cell.sequence.store(dequeue_pos + RING_SIZE, std::memory_order_release);
+            dequeue_pos++;
+            count++;
         }
-        for (const T& record : records) {
-            record.display_details();
-            std::cout << "--------------------------------------" << std::endl;
+        if (!out_batch.empty()) {
+            std::cout.write(out_batch.data(), static_cast<std::streamsize>(out_batch.size()));
+            std::cout.flush();
+            out_batch.clear();
+        }
+        if (!err_batch.empty()) {
+            std::cerr.write(err_batch.data(), static_cast<std::streamsize>(err_batch.size()));
+            err_batch.clear();
+        }
+        if (count > 0) {
+            {
+                std::lock_guard<std::mutex> lock(flush_mutex);
+                drained.store(dequeue_pos, std::memory_order_release);
+            }
+            drained_changed.notify_all();
         }
+        return count;
     }
 
-    // Reference usage to return the internal vector (avoids copy)
-    std::vector<T>& get_records() {
-        return records;
+    void drain_loop() {
+        std::string out_batch, err_batch;
+        int idle_spins = 0;
+        while (true) {
+            if (drain_ready(out_batch, err_batch) > 0) {
+                idle_spins = 0;
+            } else if (stopping.load(std::memory_order_acquire)) {
+                return;
+            } else if (++idle_spins < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
     }
 
-    // Demonstrates Inline Function definition
-    inline size_t count() const { return records.size(); }
-};
+public:
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
 
-// =====================================================================
-// MODULE 1, 4: Course Class
-// Demonstrates Class, Object, Static Members, and Operator Overloading
-// =====================================================================
-class Course {
-private:
-    // Data Members (private access specifier)
-    const int course_id; // MODULE 4: Constant Data Member
-    std::string title;
-    int capacity;
-    int enrolled_students;
+    ~Logger() { stop_async(); }
 
-public:
-    // MODULE 4: Static Data Member (tracks total courses created)
-    static int total_courses;
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= level_ref().load(std::memory_order_relaxed);
+    }
 
-    // MODULE 2: Constructor (Default Argument & 'this' pointer)
-    Course(int id, std::string t = "Untitled Course", int cap = 30)
-        : course_id(id), title(t), capacity(cap), enrolled_students(0)
-    {
-        total_courses++;
-        // Explicit use of 'this' pointer
-        this->capacity = cap;
+    static void set_level(LogLevel level) {
+        level_ref().store(static_cast<int>(level), std::memory_order_relaxed);
     }
 
-    // MODULE 2: Destructor (Simple demonstration)
-    ~Course() {
-        // total_courses--; // We don't decrement here to avoid confusion in main demo
+    // Switches to background writing
+    void start_async() {
+        std::lock_guard<std::mutex> lock(sync_mutex);
+        if (async.load()) return;
+        std::cout.flush();
+        stopping.store(false);
+        drainer = std::thread(&Logger::drain_loop, this);
+        async.store(true, std::memory_order_release);
     }
 
-    // Member Function (inside class definition - often for inline)
-    int get_id() const {
-        return course_id;
+    // Drains everything still queued and returns to synchronous writing.
+    // Producers already on the asynchronous path finish their enqueue first,
+    // and whatever they queued after the drain thread's last pass is written
+    // here, so no message is lost or left behind for the next start_async().
+    void stop_async() {
+        std::lock_guard<std::mutex> lock(sync_mutex);
+        if (!async.load()) return;
+        async.store(false);
+        while (producers.load() > 0) std::this_thread::yield(); // The drain thread is still running
+        stopping.store(true, std::memory_order_release);
+        drainer.join();
+        std::string out_batch, err_batch;
+        drain_ready(out_batch, err_batch);
+        { std::lock_guard<std::mutex> wake(flush_mutex); } // A flush() between its check and its wait sees the change
+        drained_changed.notify_all(); // Wake flush() callers: nothing is asynchronous any more
     }
-    
-    // FIX: Public Getter to access private data
-    inline int get_enrolled_students() const { return enrolled_students; }
 
-    // MODULE 4: Constant Member Function (cannot modify the object's state)
-    void display_details() const;
+    // Waits until every message submitted so far has been written
+    void flush() {
+        size_t target = enqueue_pos.load(std::memory_order_acquire);
+        {
+            std::unique_lock<std::mutex> lock(flush_mutex);
+            drained_changed.wait(lock, [&] {
+                return !async.load(std::memory_order_acquire) || drained.load(std::memory_order_acquire) >= target;
+            });
+        }
+        std::cout.flush();
+    }
 
-    void increment_enrollment() {
-        if (enrolled_students >= capacity) {
-            // MODULE 5: Exception Handling (Throwing an exception)
-            throw SystemException("Course is already full. Enrollment failed.");
+    void submit(LogLevel level, const char* text, size_t length) {
+        // 'producers' is raised before 'async' is read (both sequentially consistent),
+        // so stop_async() either sees this call in flight or this call sees async off
+        producers.fetch_add(1);
+        if (async.load()) {
+            // Back-pressure instead of dropping when the drain thread falls behind;
+            // stop_async() keeps the drain thread running until we are done
+            while (!try_enqueue(level, text, length)) {
+                std::this_thread::yield();
+            }
+            producers.fetch_sub(1, std::memory_order_release);
+            return;
         }
-        enrolled_students++;
+        producers.fetch_sub(1, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(sync_mutex);
+        std::ostream& out = stream_for(level);
+        out.write(text, static_cast<std::streamsize>(length));
+        out.put('\n');
     }
+};
 
-    // MODULE 4: Static Member Function
-    static int get_total_courses() {
-        return total_courses;
+// One log message, formatted into a fixed buffer and submitted on destruction.
+// Messages longer than Logger::MESSAGE_CAPACITY are truncated.
+class LogLine {
+private:
+    LogLevel level;
+    size_t length = 0;
+    char buffer[Logger::MESSAGE_CAPACITY];
+
+    void append(const char* text, size_t size) {
+        size = std::min(size, sizeof(buffer) - length);
+        std::memcpy(buffer + length, text, size);
+        length += size;
     }
 
-    // MODULE 4: Operator Overloading (Overloading the insertion operator <<)
-    // Declared as a friend function to allow access to private members
-    friend std::ostream& operator<<(std::ostream& os, const Course& course);
+    template <typename Int>
+    LogLine& append_integer(Int value) {
+        char digits[24];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(digits, static_cast<size_t>(result.ptr - digits));
+        return *this;
+    }
+
+public:
+    explicit LogLine(LogLevel message_level) : level(message_level) {}
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
 
-    // File Handling helper for saving
-    std::string to_string() const {
-        return std::to_string(course_id) + "|" + title + "|" + std::to_string(capacity) + "|" + std::to_string(enrolled_students);
+    ~LogLine() { Logger::instance().submit(level, buffer, length); }
+
+    LogLine& operator<<(const char* text) { append(text, std::strlen(text)); return *this; }
+    LogLine& operator<<(const std::string& text) { append(text.data(), text.size()); return *this; }
+    LogLine& operator<<(std::string_view text) { append(text.data(), text.size()); return *this; }
+    LogLine& operator<<(char c) { append(&c, 1); return *this; }
+    LogLine& operator<<(int value) { return append_integer(value); }
+    LogLine& operator<<(unsigned value) { return append_integer(value); }
+    LogLine& operator<<(long value) { return append_integer(value); }
+    LogLine& operator<<(unsigned long value) { return append_integer(value); }
+    LogLine& operator<<(long long value) { return append_integer(value); }
+    LogLine& operator<<(unsigned long long value) { return append_integer(value); }
+    LogLine& operator<<(double value) {
+        char digits[32];
+        int size = std::snprintf(digits, sizeof(digits), "%g", value);
+        append(digits, static_cast<size_t>(std::max(size, 0)));
+        return *this;
+    }
+
+    // Anything else with a stream operator (slow path, allocates)
+    template <typename T>
+    LogLine& operator<<(const T& value) {
+        std::ostringstream text;
+        text << value;
+        return *this << text.str();
     }
 };
 
-// MODULE 4: Initialization of Static Data Member
-int Course::total_courses = 0;
+// Usage: UMS_LOG(LogLevel::Info) << "Loaded " << count << " records";
+// The arguments are not evaluated at all when the level is disabled.
+#define UMS_LOG(level) \
+    if (!Logger::enabled(level)) {} else LogLine(level)
 
-// MODULE 4: Operator Overloading implementation
-std::ostream& operator<<(std::ostream& os, const Course& course) {
-    os << "Code: " << course.course_id
-       << " | Title: " << course.title
-       << " | Enrollment: " << course.enrolled_students << "/" << course.capacity;
-    return os;
+// =====================================================================
+// Metrics and Tracing
+// Counters and latency histograms for the DatabaseManager I/O paths,
+// RecordList lookups and enrollment, plus optional trace spans:
+//  - every thread writes to its own block (plain relaxed stores, no
+//    shared cache lines), and Metrics::snapshot() sums the blocks;
+//  - latencies go into log2 nanosecond buckets; find_record() and the
+//    single enroll() calls are timed on every 64th call only, because
+//    reading the clock costs about as much as the operation itself;
+//    find_record() is also counted (in steps of 64) and traced only on
+//    those calls, so its other calls cost one per-thread tick;
+//  - seat reservations are counted per course (attempts and failures)
+//    in per-thread cells indexed by a dense course slot, without a lock;
+//  - while tracing is on, timed sections and UMS_TRACE_SPAN scopes are
+//    recorded and can be written as Chrome trace-event JSON
+//    (chrome://tracing or Perfetto).
+// Build with -DUMS_NO_METRICS to compile all of it out: the UMS_COUNT /
+// UMS_TIME / UMS_TRACE_SPAN macros then expand to nothing.
+// =====================================================================
+#ifndef UMS_NO_METRICS
+#define UMS_METRICS 1
+#else
+#define UMS_METRICS 0
+#endif
+
+enum class Counter : uint8_t {
+    StudentsLoaded,
+    CoursesLoaded,
+    CorruptLines,
+    StudentsSaved,
+    CoursesSaved,
+    RecordLookups,
+    RecordLookupMisses,
+    LazyHydrations,
+    LazyEvictions,
+    Count
+};
+
+enum class Timer : uint8_t {
+    LoadStudents,
+    LoadStudentsMapped,
+    LoadStudentsParallel,
+    LoadCoursesParallel,
+    SaveStudents,
+    SaveCourses,
+    SaveSnapshot,
+    SaveAsync,
+    LoadSnapshot,
+    Recover,
+    FindRecord,
+    StudentEnroll,
+    EngineEnroll,
+    EngineEnrollBatch,
+    OpenLazy,
+    SaveLazy,
+    Count
+};
+
+inline const char* counter_name(Counter counter) {
+    static const char* const names[] = {"students_loaded", "courses_loaded", "corrupt_lines", "students_saved",
+                                        "courses_saved", "record_lookups", "record_lookup_misses",
+                                        "lazy_hydrations", "lazy_evictions"};
+    return names[static_cast<size_t>(counter)];
 }
 
-// MODULE 1: Defining Member Function Outside Class
-void Course::display_details() const {
-    std::cout << "Course Details:\n" << *this << std::endl;
+inline const char* timer_name(Timer timer) {
+    static const char* const names[] = {"db.load_students", "db.load_students_mapped", "db.load_students_parallel",
+                                        "db.load_courses_parallel", "db.save_students", "db.save_courses",
+                                        "db.save_snapshot", "db.save_async", "db.load_snapshot", "db.recover",
+                                        "record_list.find_record", "student.enroll", "engine.enroll",
+                                        "engine.enroll_batch", "lazy.open", "lazy.save"};
+    return names[static_cast<size_t>(timer)];
 }
 
-// =====================================================================
-// MODULE 3, 4: Abstract Base Class
-// Demonstrates Pure Virtual Function and the start of Polymorphism
-// =====================================================================
-class User {
-protected:
-    // Protected Access Specifier (accessible by derived classes)
-    int user_id;
-    std::string name;
+#if UMS_METRICS
+const size_t COUNTER_COUNT = static_cast<size_t>(Counter::Count);
+const size_t TIMER_COUNT = static_cast<size_t>(Timer::Count);
 
-public:
-    // Constructor
-    User(int id, std::string n) : user_id(id), name(n) {}
+// Bucket i holds latencies in [2^(i-1), 2^i) ns; the last bucket is open-ended
+struct LatencyHistogram {
+    static const size_t BUCKETS = 40;
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+    uint64_t buckets[BUCKETS] = {};
 
-    // MODULE 3: Pure Virtual Function (Makes User an Abstract Class)
-    virtual void display_details() const = 0;
+    static size_t bucket_of(uint64_t ns) {
+        size_t bucket = ns ? static_cast<size_t>(64 - __builtin_clzll(ns)) : 0;
+        return std::min(bucket, BUCKETS - 1);
+    }
 
-    // MODULE 4: Virtual Destructor (Essential for proper cleanup in inheritance hierarchies)
-    virtual ~User() {}
+    // Upper bound of the bucket that holds the p-th percentile
+    uint64_t percentile_ns(double p) const {
+        uint64_t target = static_cast<uint64_t>(std::ceil(p / 100.0 * count)), seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= target && seen > 0) return uint64_t(1) << i;
+        }
+        return 0;
+    }
+};
 
-    // Inline Function
-    inline int get_id() const { return user_id; }
-    inline const std::string& get_name() const { return name; }
+struct CourseEnrollStats {
+    uint64_t attempts = 0;
+    uint64_t failures = 0;
 };
 
-// =====================================================================
-// MODULE 1, 3, 4: Student Class
-// Demonstrates Inheritance, Static Members, Const, Friend, Overloading
-// =====================================================================
-class Student : public User {
-private:
-    // Data Members
-    static int next_roll_number; // MODULE 4: Static Data Member (for auto-incrementing ID)
-    int roll_number;
-    std::vector<int> enrolled_course_ids;
+struct TraceEvent {
+    const char* name; // Static string (timer name or UMS_TRACE_SPAN literal)
+    int64_t start_ns; // Since Metrics::epoch()
+    int64_t duration_ns;
+    uint32_t thread;
+};
 
-    // MODULE 2: Friend Class Declaration
-    friend class DatabaseManager; // Allows DatabaseManager to access private members
+// Point-in-time copy of all metrics, summed over every thread
+struct MetricsSnapshot {
+    uint64_t counters[COUNTER_COUNT] = {};
+    LatencyHistogram timers[TIMER_COUNT];
+    std::map<int, CourseEnrollStats> courses;
+    uint64_t dropped_trace_events = 0;
 
-public:
-    // MODULE 2: Constructor (Initializes User base class, uses 'this' pointer)
-    Student(std::string n, int id) : User(id, n), roll_number(next_roll_number++) {
-        // Explicit use of 'this' pointer
-        this->user_id = id;
-        std::cout << "Student " << n << " created with Roll No: " << roll_number << std::endl;
+    inline uint64_t counter(Counter c) const { return counters[static_cast<size_t>(c)]; }
+    inline const LatencyHistogram& timer(Timer t) const { return timers[static_cast<size_t>(t)]; }
+
+    double failure_rate(int course_id) const {
+        auto it = courses.find(course_id);
+        return it == courses.end() || it->second.attempts == 0
+                   ? 0.0
+                   : static_cast<double>(it->second.failures) / it->second.attempts;
     }
 
-    // Constructor for loading from file (without auto-incrementing static counter)
-    Student(std::string n, int id, int roll) : User(id, n), roll_number(roll) {
-        // Ensure static counter is up-to-date
-        if (roll >= next_roll_number) {
-            next_roll_number = roll + 1;
+    // Prometheus text exposition format, for a scrape endpoint or a file
+    std::string to_text() const {
+        std::ostringstream out;
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+            const char* name = counter_name(static_cast<Counter>(i));
+            out << "# TYPE ums_" << name << "_total counter\n" << "ums_" << name << "_total " << counters[i] << "\n";
+        }
+        out << "# TYPE ums_latency_ns histogram\n";
+        for (size_t t = 0; t < TIMER_COUNT; ++t) {
+            const LatencyHistogram& h = timers[t];
+            if (h.count == 0) continue;
+            const char* op = timer_name(static_cast<Timer>(t));
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i + 1 < LatencyHistogram::BUCKETS && cumulative < h.count; ++i) {
+                cumulative += h.buckets[i];
+                out << "ums_latency_ns_bucket{op=\"" << op << "\",le=\"" << (uint64_t(1) << i) << "\"} " << cumulative << "\n";
+            }
+            out << "ums_latency_ns_bucket{op=\"" << op << "\",le=\"+Inf\"} " << h.count << "\n"
+                << "ums_latency_ns_sum{op=\"" << op << "\"} " << h.sum_ns << "\n"
+                << "ums_latency_ns_count{op=\"" << op << "\"} " << h.count << "\n";
         }
+        out << "# TYPE ums_course_enroll_attempts_total counter\n";
+        for (const auto& entry : courses) {
+            out << "ums_course_enroll_attempts_total{course=\"" << entry.first << "\"} " << entry.second.attempts << "\n";
+        }
+        out << "# TYPE ums_course_enroll_failures_total counter\n";
+        for (const auto& entry : courses) {
+            out << "ums_course_enroll_failures_total{course=\"" << entry.first << "\"} " << entry.second.failures << "\n";
+        }
+        out << "# TYPE ums_trace_events_dropped_total counter\n"
+            << "ums_trace_events_dropped_total " << dropped_trace_events << "\n";
+        return out.str();
     }
+};
 
-    // MODULE 2: Destructor
-    ~Student() {
-        std::cout << "Student object for " << name << " (Roll: " << roll_number << ") destroyed." << std::endl;
+class Metrics {
+private:
+    static const size_t TRACE_LIMIT_PER_THREAD = 1 << 20;
+    static const size_t COURSE_CHUNK = 256;  // Course slots per lazily allocated chunk
+    static const size_t COURSE_CHUNKS = 256; // Up to 65536 distinct course ids
+
+    struct CourseCells {
+        std::atomic<uint64_t> attempts[COURSE_CHUNK] = {};
+        std::atomic<uint64_t> failures[COURSE_CHUNK] = {};
+    };
+
+    // Written only by its own thread; atomics so snapshot() may read concurrently
+    struct ThreadBlock {
+        std::atomic<uint64_t> counters[COUNTER_COUNT] = {};
+        std::atomic<uint64_t> timer_count[TIMER_COUNT] = {};
+        std::atomic<uint64_t> timer_sum[TIMER_COUNT] = {};
+        std::atomic<uint64_t> timer_buckets[TIMER_COUNT][LatencyHistogram::BUCKETS] = {};
+        // Per-course seat requests, indexed by Metrics::course_slot(); chunks are published with release
+        std::atomic<CourseCells*> courses[COURSE_CHUNKS] = {};
+        uint32_t thread = 0;
+        uint32_t sample_tick = 0;
+
+        std::mutex mutex; // Guards the trace buffer (uncontended except during snapshots)
+        std::vector<TraceEvent> trace;
+        uint64_t dropped_trace_events = 0;
+
+        ~ThreadBlock() {
+            for (auto& chunk : courses) delete chunk.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadBlock*> live;
+        MetricsSnapshot retired; // Totals of threads that have exited
+        std::vector<TraceEvent> retired_trace;
+        uint32_t next_thread = 1;
+        std::unordered_map<int, uint32_t> course_slots; // Course id -> dense slot
+        std::vector<int> slot_courses;                  // Dense slot -> course id
+    };
+
+    static Registry& registry() {
+        static Registry* instance = new Registry(); // Never destroyed: threads may retire during static teardown
+        return *instance;
     }
 
-    // MODULE 3, 4: Function Overriding (Implements Pure Virtual Function)
-    // Demonstrates Dynamic Binding/Runtime Polymorphism
-    void display_details() const override {
-        std::cout << "--- Student Details ---" << std::endl;
-        std::cout << "ID (User): " << user_id << std::endl;
-        std::cout << "Roll No: " << roll_number << std::endl;
-        std::cout << "Name: " << name << std::endl;
-        std::cout << "Enrolled Courses: " << enrolled_course_ids.size() << std::endl;
+    static std::atomic<bool>& tracing_flag() {
+        static std::atomic<bool> flag(false);
+        return flag;
     }
 
-    // MODULE 2: Function Overloading (enroll by ID)
-    void enroll(int course_id) {
-        if (std::find(enrolled_course_ids.begin(), enrolled_course_ids.end(), course_id) == enrolled_course_ids.end()) {
-            enrolled_course_ids.push_back(course_id);
-            std::cout << name << " enrolled in course ID " << course_id << " (via ID)." << std::endl;
-        } else {
-            std::cout << name << " is already enrolled in course ID " << course_id << "." << std::endl;
-        }
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
     }
 
-    // MODULE 2: Function Overloading (enroll by Course object reference)
-    void enroll(const Course& course) {
-        // MODULE 2: Reference usage
-        int course_id = course.get_id();
-        if (std::find(enrolled_course_ids.begin(), enrolled_course_ids.end(), course_id) == enrolled_course_ids.end()) {
-            try {
-                // Throws an exception if the course is full
-                Course& mutable_course = const_cast<Course&>(course); // Casting away const for enrollment count
-                mutable_course.increment_enrollment();
-                enrolled_course_ids.push_back(course_id);
-                std::cout << name << " successfully enrolled in " << course.get_id() << " (via Object)." << std::endl;
-            } catch (const SystemException& e) {
-                // MODULE 5: Exception Handling (Catching the exception)
-                std::cerr << "ENROLLMENT ERROR: " << e.what() << std::endl;
+    static void add_block(MetricsSnapshot& into, ThreadBlock& block) {
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) into.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+        for (size_t t = 0; t < TIMER_COUNT; ++t) {
+            into.timers[t].count += block.timer_count[t].load(std::memory_order_relaxed);
+            into.timers[t].sum_ns += block.timer_sum[t].load(std::memory_order_relaxed);
+            for (size_t b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+                into.timers[t].buckets[b] += block.timer_buckets[t][b].load(std::memory_order_relaxed);
+            }
+        }
+        // Called with the registry mutex held, so slot_courses is stable
+        const std::vector<int>& slot_courses = registry().slot_courses;
+        for (size_t c = 0; c < COURSE_CHUNKS; ++c) {
+            const CourseCells* cells = block.courses[c].load(std::memory_order_acquire);
+            if (!cells) continue;
+            for (size_t i = 0; i < COURSE_CHUNK && c * COURSE_CHUNK + i < slot_courses.size(); ++i) {
+                uint64_t attempts = cells->attempts[i].load(std::memory_order_relaxed);
+                if (attempts == 0) continue;
+                CourseEnrollStats& stats = into.courses[slot_courses[c * COURSE_CHUNK + i]];
+                stats.attempts += attempts;
+                stats.failures += cells->failures[i].load(std::memory_order_relaxed);
             }
-        } else {
-            std::cout << name << " is already enrolled in course ID " << course_id << "." << std::endl;
         }
+        std::lock_guard<std::mutex> lock(block.mutex);
+        into.dropped_trace_events += block.dropped_trace_events;
     }
 
-    // MODULE 4: Static Member Function
-    static int get_total_students() {
-        return next_roll_number - 1;
-    }
+    // Owns the calling thread's block; folds it into the registry when the thread exits
+    struct LocalHolder {
+        ThreadBlock* block;
 
-    // File Handling helper for saving
-    std::string to_string() const {
-        std::string courses_str;
-        for (int id : enrolled_course_ids) {
-            courses_str += std::to_string(id) + ",";
+        LocalHolder() : block(new ThreadBlock()) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            block->thread = reg.next_thread++;
+            reg.live.push_back(block);
         }
-        if (!courses_str.empty()) {
-            courses_str.pop_back(); // Remove trailing comma
+
+        ~LocalHolder() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            add_block(reg.retired, *block);
+            reg.retired_trace.insert(reg.retired_trace.end(), block->trace.begin(), block->trace.end());
+            reg.live.erase(std::find(reg.live.begin(), reg.live.end(), block));
+            delete block;
         }
-        return std::to_string(user_id) + "|" + name + "|" + std::to_string(roll_number) + "|" + courses_str;
-    }
-};
+    };
 
-// MODULE 4: Initialization of Static Data Member
-int Student::next_roll_number = 1001;
+    __attribute__((noinline)) static ThreadBlock& register_thread() {
+        static thread_local LocalHolder holder;
+        return *holder.block;
+    }
 
-// =====================================================================
-// MODULE 3: Faculty Class (Simple Inheritance Demo)
-// =====================================================================
-class Faculty : public User {
-private:
-    std::string department;
-    // MODULE 1: Array of Objects (using Course objects)
-    std::vector<Course*> courses_taught; // MODULE 2: Demonstrating Dynamic Memory with pointers
+    // The plain pointer is constant-initialized, so the hot path skips the
+    // thread_local guard that the holder's constructor and destructor need
+    static ThreadBlock& local() {
+        static thread_local ThreadBlock* block = nullptr;
+        if (__builtin_expect(block == nullptr, 0)) block = &register_thread();
+        return *block;
+    }
 
 public:
-    // Constructor
-    Faculty(std::string n, int id, std::string dept) : User(id, n), department(dept) {
-        // Initial setup
+    static inline void add(Counter counter, uint64_t n = 1) {
+        bump(local().counters[static_cast<size_t>(counter)], n);
     }
 
-    // MODULE 3, 4: Function Overriding (Implements Pure Virtual Function)
-    void display_details() const override {
-        std::cout << "--- Faculty Details ---" << std::endl;
-        std::cout << "ID: " << user_id << std::endl;
-        std::cout << "Name: " << name << std::endl;
-        std::cout << "Department: " << department << std::endl;
-        std::cout << "Courses Taught: " << courses_taught.size() << std::endl;
+    static inline void record(Timer timer, uint64_t ns) {
+        ThreadBlock& block = local();
+        size_t t = static_cast<size_t>(timer);
+        bump(block.timer_count[t], 1);
+        bump(block.timer_sum[t], ns);
+        bump(block.timer_buckets[t][LatencyHistogram::bucket_of(ns)], 1);
     }
 
-    // MODULE 2: Dynamic Memory Allocation (using new)
-    void assign_course(Course* course_ptr) {
-        if (course_ptr) {
-            courses_taught.push_back(course_ptr);
-            std::cout << name << " assigned course " << course_ptr->get_id() << "." << std::endl;
+    // Dense per-process slot for a course id (same id, same slot); taken once per Course object
+    static uint32_t course_slot(int course_id) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto inserted = reg.course_slots.emplace(course_id, static_cast<uint32_t>(reg.slot_courses.size()));
+        if (inserted.second) reg.slot_courses.push_back(course_id);
+        return inserted.first->second;
+    }
+
+    // Seat requests against the course in 'slot' ('failures' of 'attempts' were refused).
+    // Lock-free: two relaxed adds into the calling thread's own cells.
+    static inline void record_enrollment(uint32_t slot, uint64_t attempts, uint64_t failures) {
+        if (slot >= COURSE_CHUNK * COURSE_CHUNKS) return; // Beyond the table: not tracked
+        ThreadBlock& block = local();
+        std::atomic<CourseCells*>& chunk = block.courses[slot / COURSE_CHUNK];
+        CourseCells* cells = chunk.load(std::memory_order_relaxed);
+        if (__builtin_expect(cells == nullptr, 0)) {
+            cells = new CourseCells();
+            chunk.store(cells, std::memory_order_release);
         }
+        bump(cells->attempts[slot % COURSE_CHUNK], attempts);
+        bump(cells->failures[slot % COURSE_CHUNK], failures);
     }
 
-    // MODULE 2: Destructor (Essential for cleaning up dynamically allocated resources)
-    ~Faculty() {
-        // Since the Course objects are managed externally, we only clear the pointers here.
-        // If Faculty owned the courses, we would delete the pointers in this loop.
-        courses_taught.clear();
-        std::cout << "Faculty object for " << name << " destroyed." << std::endl;
+    // True on every 64th call per thread (for sampled timers)
+    static inline bool sample_tick() {
+        return (++local().sample_tick & 63) == 0;
     }
-};
 
-// =====================================================================
-// MODULE 2, 5: DatabaseManager Class
-// Demonstrates Friend Class, Stream Class, and File Handling
-// =====================================================================
-class DatabaseManager {
-private:
-    const std::string STUDENT_FILE = "student_records.txt";
-    const std::string COURSE_FILE = "course_records.txt";
+    // Sampled counting: on every 64th call per thread adds 64 to 'counter' and returns
+    // true, so the counter is exact to within 63 per thread and costs one tick otherwise
+    static inline bool sample_tick(Counter counter) {
+        ThreadBlock& block = local();
+        if ((++block.sample_tick & 63) != 0) return false;
+        bump(block.counters[static_cast<size_t>(counter)], 64);
+        return true;
+    }
 
-    // Helper to tokenize a line
-    std::vector<std::string> split(const std::string& s, char delimiter) const {
-        std::vector<std::string> tokens;
-        std::string token;
-        std::istringstream tokenStream(s);
-        while (std::getline(tokenStream, token, delimiter)) {
-            tokens.push_back(token);
-        }
-        return tokens;
+    static MetricsSnapshot snapshot() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        MetricsSnapshot result = reg.retired;
+        for (ThreadBlock* block : reg.live) add_block(result, *block);
+        return result;
     }
 
-public:
-    // MODULE 5: File Handling (Writing to file - Stream Class usage)
-    void save_students(RecordList<Student>& student_list) {
-        std::ofstream outfile(STUDENT_FILE); // Stream Class
-        if (!outfile.is_open()) {
-            // MODULE 5: Exception Handling (Throwing for file error)
-            throw SystemException("Could not open student file for writing.");
+    // Writes snapshot().to_text() to 'path' (temporary file + rename, so a scraper never sees half a file)
+    static void write_text(const std::string& path) {
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            out << snapshot().to_text();
+            if (!out) throw SystemException("Could not write metrics file " + temp + ".");
         }
-
-        for (const Student& s : student_list.get_records()) {
-            // MODULE 2: Accessing private members of Student via Friend Class
-            outfile << s.to_string() << "\n";
+        if (std::rename(temp.c_str(), path.c_str()) != 0) {
+            throw SystemException("Could not rename " + temp + " to " + path + ".");
         }
-        outfile.close();
-        std::cout << "\n[DB] Student records saved successfully." << std::endl;
     }
 
-    // MODULE 5: File Handling (Reading from file - Stream Class usage)
-    void load_students(RecordList<Student>& student_list) {
-        student_list.get_records().clear();
-        std::ifstream infile(STUDENT_FILE); // Stream Class
+    // ---- Tracing ----
+    static std::chrono::steady_clock::time_point epoch() {
+        static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        return start;
+    }
 
-        if (!infile.is_open()) {
-            std::cout << "\n[DB] Student file not found. Starting with empty database." << std::endl;
+    static void start_tracing() {
+        epoch();
+        tracing_flag().store(true, std::memory_order_relaxed);
+    }
+    static void stop_tracing() { tracing_flag().store(false, std::memory_order_relaxed); }
+    static inline bool tracing() { return tracing_flag().load(std::memory_order_relaxed); }
+
+    static void record_span(const char* name, std::chrono::steady_clock::time_point start,
+                            std::chrono::steady_clock::time_point end) {
+        ThreadBlock& block = local();
+        std::lock_guard<std::mutex> lock(block.mutex);
+        if (block.trace.size() >= TRACE_LIMIT_PER_THREAD) {
+            block.dropped_trace_events++;
             return;
         }
+        block.trace.push_back({name, std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch()).count(),
+                               std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), block.thread});
+    }
+
+    // Writes every recorded span as Chrome trace-event JSON ("X" complete events, microseconds)
+    static void write_chrome_trace(const std::string& path) {
+        std::vector<TraceEvent> events;
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            events = reg.retired_trace;
+            for (ThreadBlock* block : reg.live) {
+                std::lock_guard<std::mutex> block_lock(block->mutex);
+                events.insert(events.end(), block->trace.begin(), block->trace.end());
+            }
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) throw SystemException("Could not open trace file " + path + ".");
+        out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+        for (size_t i = 0; i < events.size(); ++i) {
+            const TraceEvent& e = events[i];
+            out << (i ? ",\n" : "\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":" << ::getpid()
+                << ",\"tid\":" << e.thread << ",\"ts\":" << e.start_ns / 1000.0 << ",\"dur\":" << e.duration_ns / 1000.0
+                << "}";
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    // Drops all recorded spans
+    static void clear_trace() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.retired_trace.clear();
+        for (ThreadBlock* block : reg.live) {
+            std::lock_guard<std::mutex> block_lock(block->mutex);
+            block->trace.clear();
+        }
+    }
+};
+
+// Times a scope into a Timer histogram (and a trace span while tracing is on)
+class ScopedTimer {
+private:
+    Timer timer;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(Timer t, bool sample = true) : timer(t), active(sample || Metrics::tracing()) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer() {
+        if (!active) return;
+        auto end = std::chrono::steady_clock::now();
+        Metrics::record(timer, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        if (Metrics::tracing()) Metrics::record_span(timer_name(timer), start, end);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// Trace-only scope (no histogram); costs one flag check while tracing is off
+class TraceSpan {
+private:
+    const char* name;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit TraceSpan(const char* span_name) : name(span_name), active(Metrics::tracing()) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+
+    ~TraceSpan() {
+        if (active) Metrics::record_span(name, start, std::chrono::steady_clock::now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define UMS_METRICS_CONCAT_(a, b) a##b
+#define UMS_METRICS_CONCAT(a, b) UMS_METRICS_CONCAT_(a, b)
+#define UMS_COUNT(counter, n) Metrics::add(counter, n)
+#define UMS_TIME(timer) ScopedTimer UMS_METRICS_CONCAT(ums_timer_, __LINE__)(timer)
+#define UMS_TIME_SAMPLED(timer) ScopedTimer UMS_METRICS_CONCAT(ums_timer_, __LINE__)(timer, Metrics::sample_tick())
+#define UMS_TIME_COUNT_SAMPLED(timer, counter) \
+    ScopedTimer UMS_METRICS_CONCAT(ums_timer_, __LINE__)(timer, Metrics::sample_tick(counter))
+#define UMS_TRACE_SPAN(name) TraceSpan UMS_METRICS_CONCAT(ums_span_, __LINE__)(name)
+#define UMS_COUNT_ENROLLMENT(slot, attempts, failures) Metrics::record_enrollment(slot, attempts, failures)
+#else
+#define UMS_COUNT(counter, n) ((void)0)
+#define UMS_TIME(timer) ((void)0)
+#define UMS_TIME_SAMPLED(timer) ((void)0)
+#define UMS_TIME_COUNT_SAMPLED(timer, counter) ((void)0)
+#define UMS_TRACE_SPAN(name) ((void)0)
+#define UMS_COUNT_ENROLLMENT(slot, attempts, failures) ((void)0)
+#endif
+
+// =====================================================================
+// Work-Stealing Thread Pool
+// Runs bulk jobs (loading, saving, index rebuilds, reports) on a fixed
+// set of worker threads:
+//  - every worker owns a deque: it pushes and pops its own tasks at the
+//    back (newest first, still warm in its cache) while idle workers
+//    steal from the front (the oldest, and with parallel_for the largest,
+//    pieces of work);
+//  - a TaskGroup tracks a batch of tasks; wait() runs queued tasks
+//    itself instead of blocking, so groups can nest inside tasks;
+//  - parallel_for() halves a range recursively, so work spreads out with
+//    a handful of steals instead of one shared queue;
+//  - a push locks only its target deque; the idle lock and condition
+//    variable are touched only while some worker is asleep.
+// ThreadPool::shared() is the process-wide pool (one worker per core).
+// =====================================================================
+class TaskGroup;
+
+class ThreadPool {
+private:
+    using Task = std::function<void()>;
+
+    struct alignas(64) Worker { // One cache line apart, so deques do not false-share
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> sleeping{0};    // Workers waiting (or about to wait) on idle_cv
+    std::atomic<size_t> next_worker{0}; // Round robin for tasks pushed from outside the pool
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+    bool stopping = false; // Guarded by idle_mutex
+
+    // The pool and worker index of the calling thread (nullptr outside any pool)
+    static thread_local ThreadPool* current_pool;
+    static thread_local size_t current_worker;
+
+    friend class TaskGroup;
+
+    // Only touches the target deque's lock; idle_mutex is taken only when a worker is asleep.
+    // No lost wake-ups: a worker counts itself in 'sleeping' before it re-checks the deques
+    // (under their locks), so either it sees this task or this push sees it sleeping.
+    void push(Task task) {
+        size_t target = (current_pool == this) ? current_worker : next_worker++ % workers.size();
+        {
+            std::lock_guard<std::mutex> lock(workers[target]->mutex);
+            workers[target]->tasks.push_back(std::move(task));
+        }
+        if (sleeping.load() > 0) {
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex); // The sleeper is either waiting or still holds it
+            }
+            idle_cv.notify_one();
+        }
+    }
+
+    bool has_task() {
+        for (const auto& worker : workers) {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            if (!worker->tasks.empty()) return true;
+        }
+        return false;
+    }
+
+    // Takes a task from the back of the home deque, else steals from the front of another
+    bool take(size_t home, Task& task) {
+        if (home < workers.size()) {
+            Worker& own = *workers[home];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        size_t start = (home < workers.size()) ? home + 1 : 0;
+        for (size_t k = 0; k < workers.size(); ++k) {
+            Worker& victim = *workers[(start + k) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(size_t index) {
+        current_pool = this;
+        current_worker = index;
+        Task task;
+        while (true) {
+            if (take(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            sleeping.fetch_add(1);
+            bool idle = !has_task();
+            if (idle && !stopping) idle_cv.wait(lock);
+            sleeping.fetch_sub(1);
+            if (idle && stopping) return; // Every queued task has run
+        }
+    }
+
+public:
+    // thread_count 0: one worker per hardware thread
+    explicit ThreadPool(unsigned thread_count = 0) {
+        if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < thread_count; ++i) workers.push_back(std::make_unique<Worker>());
+        for (unsigned i = 0; i < thread_count; ++i) threads.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs every queued task, then stops the workers
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            stopping = true;
+        }
+        idle_cv.notify_all();
+        for (std::thread& t : threads) t.join();
+    }
+
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    inline size_t size() const { return workers.size(); }
+
+    // Runs one queued task on the calling thread; false if there was none
+    bool run_pending_task() {
+        Task task;
+        if (!take(current_pool == this ? current_worker : workers.size(), task)) return false;
+        task();
+        return true;
+    }
+
+    // Calls fn(lo, hi) on disjoint sub-ranges covering [begin, end), in
+    // parallel, and returns when all are done. 'grain' is the largest
+    // range handed to one call (0: about 8 pieces per worker).
+    // The first exception thrown by fn is rethrown here.
+    template <typename Fn>
+    void parallel_for(size_t begin, size_t end, Fn fn, size_t grain = 0);
+};
+
+thread_local ThreadPool* ThreadPool::current_pool = nullptr;
+thread_local size_t ThreadPool::current_worker = 0;
+
+// A batch of tasks that can be waited for as a whole
+class TaskGroup {
+private:
+    ThreadPool& pool;
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t pending = 0; // Guarded by 'mutex'
+    std::exception_ptr error;
+
+    bool finished() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending == 0;
+    }
+
+public:
+    explicit TaskGroup(ThreadPool& p = ThreadPool::shared()) : pool(p) {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Tasks may reference the group's caller, so they must finish first
+    ~TaskGroup() {
+        try {
+            wait();
+        } catch (...) {
+        }
+    }
+
+    template <typename Fn>
+    void run(Fn fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending++;
+        }
+        pool.push([this, fn = std::move(fn)]() mutable {
+            std::exception_ptr failure;
+            try {
+                fn();
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            // Last use of the group: wait() may destroy it once 'pending' drops to zero
+            std::lock_guard<std::mutex> lock(mutex);
+            if (failure && !error) error = failure;
+            if (--pending == 0) done.notify_all();
+        });
+    }
+
+    // Helps run queued tasks until every task of the group has finished,
+    // then rethrows the first exception one of them threw
+    void wait() {
+        while (!finished()) {
+            if (!pool.run_pending_task()) {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait_for(lock, std::chrono::microseconds(200), [&] { return pending == 0; });
+            }
+        }
+        std::exception_ptr failure;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(failure, error);
+        }
+        if (failure) std::rethrow_exception(failure);
+    }
+};
+
+template <typename Fn>
+void ThreadPool::parallel_for(size_t begin, size_t end, Fn fn, size_t grain) {
+    if (begin >= end) return;
+    if (grain == 0) grain = std::max<size_t>(1, (end - begin) / (size() * 8));
+    if (end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+    TaskGroup group(*this);
+    // Keeps the lower half and queues the upper half until a piece fits the grain
+    std::function<void(size_t, size_t)> split = [&](size_t lo, size_t hi) {
+        while (hi - lo > grain) {
+            size_t mid = lo + (hi - lo) / 2;
+            group.run([&split, mid, hi] { split(mid, hi); });
+            hi = mid;
+        }
+        fn(lo, hi);
+    };
+    try {
+        split(begin, end);
+    } catch (...) {
+        group.wait(); // Queued pieces still reference 'split' and 'fn'
+        throw;
+    }
+    group.wait();
+}
+
+// =====================================================================
+// SIMD Kernels for Course-ID Lists
+// Vectorized building blocks for enrollment checks and reporting:
+//  - contains:  is a course ID in a (short, unsorted) list?
+//  - intersect: common elements of two sorted, duplicate-free lists
+//  - minmax:    range of a list (sizes the counters of a histogram)
+// AVX2 and SSE4.2 versions are compiled with target attributes and picked
+// once at runtime from the CPU's feature flags, with a scalar fallback on
+// older CPUs and non-x86 builds.
+// =====================================================================
+inline bool simd_contains_scalar(const int* data, size_t size, int value) {
+    return std::find(data, data + size, value) != data + size;
+}
+
+inline size_t simd_intersect_scalar(const int* a, size_t a_size, const int* b, size_t b_size, int* out) {
+    return static_cast<size_t>(std::set_intersection(a, a + a_size, b, b + b_size, out) - out);
+}
+
+inline void simd_minmax_scalar(const int* data, size_t size, int& lowest, int& highest) {
+    for (size_t i = 0; i < size; ++i) {
+        lowest = std::min(lowest, data[i]);
+        highest = std::max(highest, data[i]);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse4.2"))) inline bool simd_contains_sse(const int* data, size_t size, int value) {
+    __m128i needle = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(block, needle))) return true;
+    }
+    return simd_contains_scalar(data + i, size - i, value);
+}
+
+__attribute__((target("avx2"))) inline bool simd_contains_avx2(const int* data, size_t size, int value) {
+    __m256i needle = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(block, needle))) return true;
+    }
+    return simd_contains_sse(data + i, size - i, value);
+}
+
+// Block-wise intersection: compare 4 elements of 'a' against all rotations of
+// 4 elements of 'b', emit the matches, then advance the block with the smaller maximum
+__attribute__((target("sse4.2"))) inline size_t simd_intersect_sse(const int* a, size_t a_size, const int* b,
+                                                                   size_t b_size, int* out) {
+    size_t i = 0, j = 0, count = 0;
+    while (i + 4 <= a_size && j + 4 <= b_size) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+        for (int mask = _mm_movemask_ps(_mm_castsi128_ps(hits)); mask; mask &= mask - 1) {
+            out[count++] = a[i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)))];
+        }
+        int a_max = a[i + 3], b_max = b[j + 3];
+        if (a_max <= b_max) i += 4;
+        if (b_max <= a_max) j += 4;
+    }
+    return count + simd_intersect_scalar(a + i, a_size - i, b + j, b_size - j, out + count);
+}
+
+__attribute__((target("avx2"))) inline size_t simd_intersect_avx2(const int* a, size_t a_size, const int* b,
+                                                                  size_t b_size, int* out) {
+    size_t i = 0, j = 0, count = 0;
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    while (i + 8 <= a_size && j + 8 <= b_size) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+        __m256i hits = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; ++r) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi32(va, vb));
+        }
+        for (int mask = _mm256_movemask_ps(_mm256_castsi256_ps(hits)); mask; mask &= mask - 1) {
+            out[count++] = a[i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)))];
+        }
+        int a_max = a[i + 7], b_max = b[j + 7];
+        if (a_max <= b_max) i += 8;
+        if (b_max <= a_max) j += 8;
+    }
+    return count + simd_intersect_sse(a + i, a_size - i, b + j, b_size - j, out + count);
+}
+
+__attribute__((target("sse4.2"))) inline void simd_minmax_sse(const int* data, size_t size, int& lowest, int& highest) {
+    size_t i = 0;
+    if (size >= 4) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i high = low;
+        for (i = 4; i + 4 <= size; i += 4) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            low = _mm_min_epi32(low, block);
+            high = _mm_max_epi32(high, block);
+        }
+        alignas(16) int lows[4], highs[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lows), low);
+        _mm_store_si128(reinterpret_cast<__m128i*>(highs), high);
+        simd_minmax_scalar(lows, 4, lowest, highest);
+        simd_minmax_scalar(highs, 4, lowest, highest);
+    }
+    simd_minmax_scalar(data + i, size - i, lowest, highest);
+}
+
+__attribute__((target("avx2"))) inline void simd_minmax_avx2(const int* data, size_t size, int& lowest, int& highest) {
+    size_t i = 0;
+    if (size >= 8) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        __m256i high = low;
+        for (i = 8; i + 8 <= size; i += 8) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            low = _mm256_min_epi32(low, block);
+            high = _mm256_max_epi32(high, block);
+        }
+        alignas(32) int lows[8], highs[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lows), low);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(highs), high);
+        simd_minmax_scalar(lows, 8, lowest, highest);
+        simd_minmax_scalar(highs, 8, lowest, highest);
+    }
+    simd_minmax_sse(data + i, size - i, lowest, highest);
+}
+#endif
+
+// The kernel set chosen for this CPU
+struct SimdKernels {
+    const char* name;
+    bool (*contains)(const int*, size_t, int);
+    size_t (*intersect)(const int*, size_t, const int*, size_t, int*);
+    void (*minmax)(const int*, size_t, int&, int&);
+};
+
+inline SimdKernels scalar_kernels() {
+    return SimdKernels{"scalar", simd_contains_scalar, simd_intersect_scalar, simd_minmax_scalar};
+}
+
+inline const SimdKernels& simd_kernels() {
+    static const SimdKernels kernels = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdKernels{"avx2", simd_contains_avx2, simd_intersect_avx2, simd_minmax_avx2};
+        }
+        if (__builtin_cpu_supports("sse4.2")) {
+            return SimdKernels{"sse4.2", simd_contains_sse, simd_intersect_sse, simd_minmax_sse};
+        }
+#endif
+        return scalar_kernels();
+    }();
+    return kernels;
+}
+
+// Works for any contiguous int vector (std::vector or std::pmr::vector)
+template <typename IntVector>
+inline bool simd_contains(const IntVector& values, int value) {
+    return simd_kernels().contains(values.data(), values.size(), value);
+}
+
+// 'out' must have room for min(a_size, b_size) elements; returns how many were written
+inline size_t simd_intersect_sorted(const int* a, size_t a_size, const int* b, size_t b_size, int* out) {
+    return simd_kernels().intersect(a, a_size, b, b_size, out);
+}
+
+// Counts how often each value occurs: returns (value, count) pairs sorted by value.
+// The range is found with the SIMD min/max kernel; when it is small enough the
+// counting uses four interleaved counter tables so consecutive equal IDs do not
+// stall on the same counter.
+inline std::vector<std::pair<int, size_t>> simd_histogram(const int* values, size_t size) {
+    std::vector<std::pair<int, size_t>> result;
+    if (size == 0) return result;
+
+    int lowest = values[0], highest = values[0];
+    simd_kernels().minmax(values, size, lowest, highest);
+    size_t span = static_cast<size_t>(static_cast<int64_t>(highest) - lowest) + 1;
+
+    if (span <= (1u << 16)) {
+        std::vector<uint32_t> counts(span * 4, 0);
+        uint32_t* c0 = counts.data();
+        uint32_t* c1 = c0 + span;
+        uint32_t* c2 = c1 + span;
+        uint32_t* c3 = c2 + span;
+        size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            c0[values[i] - lowest]++;
+            c1[values[i + 1] - lowest]++;
+            c2[values[i + 2] - lowest]++;
+            c3[values[i + 3] - lowest]++;
+        }
+        for (; i < size; ++i) c0[values[i] - lowest]++;
+        for (size_t v = 0; v < span; ++v) {
+            size_t total = size_t(c0[v]) + c1[v] + c2[v] + c3[v];
+            if (total) result.emplace_back(lowest + static_cast<int>(v), total);
+        }
+    } else if (span <= (1u << 22)) {
+        std::vector<size_t> counts(span, 0);
+        for (size_t i = 0; i < size; ++i) counts[static_cast<size_t>(values[i] - lowest)]++;
+        for (size_t v = 0; v < span; ++v) {
+            if (counts[v]) result.emplace_back(lowest + static_cast<int>(v), counts[v]);
+        }
+    } else {
+        std::unordered_map<int, size_t> counts;
+        for (size_t i = 0; i < size; ++i) counts[values[i]]++;
+        result.assign(counts.begin(), counts.end());
+        std::sort(result.begin(), result.end());
+    }
+    return result;
+}
+
+// =====================================================================
+// Open-Addressing Hash Index
+// Maps a record ID to its position inside RecordList's vector.
+// Linear probing keeps the table in one flat array (cache friendly) and
+// backward-shift deletion means we never need tombstones.
+// =====================================================================
+class IdIndex {
+private:
+    struct Slot {
+        int key;
+        size_t value; // EMPTY marks an unused slot
+    };
+    static constexpr size_t EMPTY = static_cast<size_t>(-1);
+
+    std::vector<Slot> slots;
+    size_t used = 0;
+    int shift = 64; // 64 - log2(slots.size()), used by Fibonacci hashing
+
+    size_t home_of(int key) const {
+        // Fibonacci hashing spreads sequential IDs across the whole table
+        return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    void grow() {
+        std::vector<Slot> old_slots;
+        old_slots.swap(slots);
+        size_t new_size = old_slots.empty() ? 16 : old_slots.size() * 2;
+        slots.assign(new_size, Slot{0, EMPTY});
+        shift = 64;
+        for (size_t s = new_size; s > 1; s >>= 1) shift--;
+        used = 0;
+        for (const Slot& slot : old_slots) {
+            if (slot.value != EMPTY) insert(slot.key, slot.value);
+        }
+    }
+
+    // Returns the slot holding 'key', or EMPTY if the key is absent
+    size_t locate(int key) const {
+        if (slots.empty()) return EMPTY;
+        size_t mask = slots.size() - 1;
+        for (size_t i = home_of(key);; i = (i + 1) & mask) {
+            if (slots[i].value == EMPTY) return EMPTY;
+            if (slots[i].key == key) return i;
+        }
+    }
+
+public:
+    // Inserts key -> value. Returns false (and keeps the old value) if the key already exists.
+    bool insert(int key, size_t value) {
+        // Keep the load factor under 70% so probe sequences stay short
+        if ((used + 1) * 10 > slots.size() * 7) grow();
+        size_t mask = slots.size() - 1;
+        for (size_t i = home_of(key);; i = (i + 1) & mask) {
+            if (slots[i].value == EMPTY) {
+                slots[i] = Slot{key, value};
+                used++;
+                return true;
+            }
+            if (slots[i].key == key) return false;
+        }
+    }
+
+    bool find(int key, size_t& value_out) const {
+        size_t i = locate(key);
+        if (i == EMPTY) return false;
+        value_out = slots[i].value;
+        return true;
+    }
+
+    void update(int key, size_t value) {
+        size_t i = locate(key);
+        if (i != EMPTY) slots[i].value = value;
+    }
+
+    bool erase(int key) {
+        size_t i = locate(key);
+        if (i == EMPTY) return false;
+        size_t mask = slots.size() - 1;
+        // Backward-shift deletion: pull later entries of the probe chain into the hole
+        for (size_t j = (i + 1) & mask; slots[j].value != EMPTY; j = (j + 1) & mask) {
+            size_t k = home_of(slots[j].key);
+            bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!stays) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i].value = EMPTY;
+        used--;
+        return true;
+    }
+
+    void reserve(size_t count) {
+        while (count * 10 > slots.size() * 7) grow();
+    }
+
+    void clear() {
+        slots.clear();
+        used = 0;
+        shift = 64;
+    }
+
+    inline size_t size() const { return used; }
+};
+
+// =====================================================================
+// Secondary Indexes for RecordList
+// Pluggable lookups on keys other than get_id(). Indexes store record IDs
+// (not positions or pointers), so they never go stale when the
+// underlying vector reallocates or records are moved around.
+// =====================================================================
+template <typename T>
+class SecondaryIndex {
+public:
+    virtual void on_insert(const T& record) = 0;
+    virtual void on_erase(const T& record) = 0;
+    virtual void clear() = 0;
+    virtual ~SecondaryIndex() {}
+};
+
+// Unique key -> record ID (e.g. Student by roll number)
+template <typename T, typename Key>
+class KeyIndex : public SecondaryIndex<T> {
+private:
+    std::function<Key(const T&)> key_of;
+    std::unordered_map<Key, int> ids;
+
+public:
+    explicit KeyIndex(std::function<Key(const T&)> key_fn) : key_of(std::move(key_fn)) {}
+
+    void on_insert(const T& record) override {
+        ids.emplace(key_of(record), record.get_id());
+    }
+
+    void on_erase(const T& record) override {
+        auto it = ids.find(key_of(record));
+        if (it != ids.end() && it->second == record.get_id()) {
+            ids.erase(it);
+        }
+    }
+
+    void clear() override { ids.clear(); }
+
+    bool lookup(const Key& key, int& id_out) const {
+        auto it = ids.find(key);
+        if (it == ids.end()) return false;
+        id_out = it->second;
+        return true;
+    }
+};
+
+// Ordered string key -> record IDs, supports prefix queries (e.g. User by name prefix)
+template <typename T>
+class PrefixIndex : public SecondaryIndex<T> {
+private:
+    std::function<std::string(const T&)> key_of;
+    std::multimap<std::string, int> entries;
+
+public:
+    explicit PrefixIndex(std::function<std::string(const T&)> key_fn) : key_of(std::move(key_fn)) {}
+
+    void on_insert(const T& record) override {
+        entries.emplace(key_of(record), record.get_id());
+    }
+
+    void on_erase(const T& record) override {
+        auto range = entries.equal_range(key_of(record));
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == record.get_id()) {
+                entries.erase(it);
+                return;
+            }
+        }
+    }
+
+    void clear() override { entries.clear(); }
+
+    std::vector<int> lookup_prefix(const std::string& prefix, size_t limit = static_cast<size_t>(-1)) const {
+        std::vector<int> result;
+        for (auto it = entries.lower_bound(prefix);
+             it != entries.end() && result.size() < limit && it->first.compare(0, prefix.size(), prefix) == 0;
+             ++it) {
+            result.push_back(it->second);
+        }
+        return result;
+    }
+};
+
+// =====================================================================
+// MODULE 5: Template Class
+// A generic container to manage lists of any type of record (Student, Course, etc.)
+// =====================================================================
+template <typename T>
+class RecordList {
+private:
+    std::vector<T> records; // Internal storage for the array of objects
+
+    // Indexed mode: get_id() -> position in 'records'
+    bool indexed = false;
+    bool has_duplicate_ids = false;
+    IdIndex id_index;
+    std::vector<std::unique_ptr<SecondaryIndex<T>>> secondary_indexes;
+
+    void index_record(size_t pos) {
+        if (indexed && !id_index.insert(records[pos].get_id(), pos)) {
+            // Keep the first record for the ID, just like the linear scan does
+            has_duplicate_ids = true;
+        }
+        for (auto& index : secondary_indexes) {
+            index->on_insert(records[pos]);
+        }
+    }
+
+#if UMS_METRICS
+    // Sampled find_record(): kept out of line so the untimed path stays small
+    __attribute__((noinline)) T* find_record_timed(int id) {
+        UMS_TIME(Timer::FindRecord);
+        size_t pos;
+        if (position_of(id, pos)) return &records[pos];
+        return record_missed();
+    }
+#endif
+
+    // Counts a failed lookup (every miss is counted; misses are the rare path)
+    __attribute__((noinline)) static T* record_missed() {
+        UMS_COUNT(Counter::RecordLookupMisses, 1);
+        return nullptr;
+    }
+
+    bool position_of(int id, size_t& pos) const {
+        if (indexed) {
+            return id_index.find(id, pos);
+        }
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (records[i].get_id() == id) {
+                pos = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    // Stable handle to a record. It remembers the ID rather than a raw T*,
+    // so it stays valid when the vector reallocates and resolves to
+    // nullptr once the record has been removed.
+    class Handle {
+    private:
+        RecordList* list;
+        int id;
+
+    public:
+        Handle(RecordList* l = nullptr, int record_id = 0) : list(l), id(record_id) {}
+
+        T* get() const { return list ? list->find_record(id) : nullptr; }
+        T* operator->() const { return get(); }
+        explicit operator bool() const { return get() != nullptr; }
+        inline int get_id() const { return id; }
+    };
+
+    // Demonstrates Function with Default Arguments
+    void add_record(const T& record, bool verbose = true) {
+        records.push_back(record);
+        index_record(records.size() - 1);
+        if (verbose) {
+            UMS_LOG(LogLevel::Info) << "[INFO] Record successfully added to the list.";
+        }
+    }
+
+    // Move-aware overload: bulk loaders hand over freshly parsed records without a copy
+    void add_record(T&& record, bool verbose = true) {
+        records.push_back(std::move(record));
+        index_record(records.size() - 1);
+        if (verbose) {
+            UMS_LOG(LogLevel::Info) << "[INFO] Record successfully added to the list.";
+        }
+    }
+
+    // Constructs the record in place and returns it
+    template <typename... Args>
+    T& emplace_record(Args&&... args) {
+        records.emplace_back(std::forward<Args>(args)...);
+        index_record(records.size() - 1);
+        return records.back();
+    }
+
+    T* find_record(int id) {
+#if UMS_METRICS
+        // Only every 64th call per thread is counted, timed and traced (see Metrics::sample_tick)
+        if (__builtin_expect(Metrics::sample_tick(Counter::RecordLookups), 0)) return find_record_timed(id);
+#endif
+        size_t pos;
+        if (position_of(id, pos)) return &records[pos];
+        return record_missed();
+    }
+
+    Handle get_handle(int id) {
+        return Handle(this, id);
+    }
+
+    // Removes the record with the given ID in O(1) when indexed.
+    // Note: the last record is moved into the gap, so insertion order is not preserved.
+    bool remove_record(int id) {
+        size_t pos;
+        if (!position_of(id, pos)) return false;
+
+        for (auto& index : secondary_indexes) {
+            index->on_erase(records[pos]);
+        }
+        size_t last = records.size() - 1;
+        if (indexed) {
+            id_index.erase(id);
+            // Repoint the moved record only if the index refers to it (not to an earlier duplicate)
+            size_t moved_pos;
+            if (pos != last && id_index.find(records[last].get_id(), moved_pos) && moved_pos == last) {
+                id_index.update(records[last].get_id(), pos);
+            }
+        }
+        if (pos != last) {
+            records[pos] = std::move(records[last]);
+        }
+        records.pop_back();
+
+        // A duplicate of the removed ID may still be in the list; point the index at it
+        if (indexed && has_duplicate_ids) {
+            for (size_t i = 0; i < records.size(); ++i) {
+                if (records[i].get_id() == id) {
+                    id_index.insert(id, i);
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Switches on the O(1) hash index for find_record()
+    void enable_index() {
+        if (indexed) return;
+        indexed = true;
+        rebuild_indexes();
+    }
+
+    inline bool is_indexed() const { return indexed; }
+
+    // Plugs in a secondary index and fills it with the current records
+    template <typename Index>
+    Index* add_index(std::unique_ptr<Index> index) {
+        for (const T& record : records) {
+            index->on_insert(record);
+        }
+        Index* raw = index.get();
+        secondary_indexes.push_back(std::move(index));
+        return raw;
+    }
+
+    template <typename Key>
+    T* find_by(const KeyIndex<T, Key>& index, const Key& key) {
+        int id;
+        return index.lookup(key, id) ? find_record(id) : nullptr;
+    }
+
+    std::vector<T*> find_by_prefix(const PrefixIndex<T>& index, const std::string& prefix) {
+        std::vector<T*> result;
+        for (int id : index.lookup_prefix(prefix)) {
+            if (T* record = find_record(id)) result.push_back(record);
+        }
+        return result;
+    }
+
+    // Must be called after modifying records directly through get_records()
+    void rebuild_indexes() {
+        id_index.clear();
+        has_duplicate_ids = false;
+        for (auto& index : secondary_indexes) {
+            index->clear();
+        }
+        if (indexed) id_index.reserve(records.size());
+        for (size_t i = 0; i < records.size(); ++i) {
+            index_record(i);
+        }
+    }
+
+    void clear() {
+        records.clear();
+        rebuild_indexes();
+    }
+
+    void reserve(size_t capacity) {
+        records.reserve(capacity);
+        if (indexed) id_index.reserve(capacity);
+    }
+
+    void display_all() const {
+        if (records.empty()) {
+            std::cout << "No records found." << std::endl;
+            return;
+        }
+        for (const T& record : records) {
+            record.display_details();
+            std::cout << "--------------------------------------" << std::endl;
+        }
+    }
+
+    // Reference usage to return the internal vector (avoids copy)
+    std::vector<T>& get_records() {
+        return records;
+    }
+
+    const std::vector<T>& get_records() const {
+        return records;
+    }
+
+    // Calls fn(record) for every record on the pool's workers. Each record is
+    // visited by exactly one task, so fn may modify it, but anything shared
+    // between records (indexes, counters, the console) needs its own locking.
+    template <typename Fn>
+    void parallel_for_each(ThreadPool& pool, Fn fn, size_t grain = 0) {
+        pool.parallel_for(0, records.size(), [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) fn(records[i]);
+        }, grain);
+    }
+
+    template <typename Fn>
+    void parallel_for_each(ThreadPool& pool, Fn fn, size_t grain = 0) const {
+        pool.parallel_for(0, records.size(), [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) fn(records[i]);
+        }, grain);
+    }
+
+    // Demonstrates Inline Function definition
+    inline size_t count() const { return records.size(); }
+};
+
+// =====================================================================
+// MODULE 1, 4: Course Class
+// Demonstrates Class, Object, Static Members, and Operator Overloading
+// =====================================================================
+class Course {
+private:
+    // Data Members (private access specifier)
+    const int course_id; // MODULE 4: Constant Data Member
+    std::string title;
+    int capacity;
+    std::atomic<int> enrolled_students; // Atomic so seats can be reserved from many threads
+#if UMS_METRICS
+    const uint32_t metrics_slot = Metrics::course_slot(course_id); // Per-course enrollment stats cell
+#endif
+
+    friend class DatabaseManager; // Loader restores the saved enrollment count
+    friend class SeatCoordinator; // Recounts seats from the shards' enrollments
+
+public:
+    // MODULE 4: Static Data Member (tracks total courses created)
+    static int total_courses;
+
+    // MODULE 2: Constructor (Default Argument & 'this' pointer)
+    Course(int id, std::string t = "Untitled Course", int cap = 30)
+        : course_id(id), title(t), capacity(cap), enrolled_students(0)
+    {
+        total_courses++;
+        // Explicit use of 'this' pointer
+        this->capacity = cap;
+    }
+
+    // Copy Constructor (needed because std::atomic is not copyable)
+    Course(const Course& other)
+        : course_id(other.course_id), title(other.title), capacity(other.capacity),
+          enrolled_students(other.enrolled_students.load()) {}
+
+    // MODULE 2: Destructor (Simple demonstration)
+    ~Course() {
+        // total_courses--; // We don't decrement here to avoid confusion in main demo
+    }
+
+    // Member Function (inside class definition - often for inline)
+    int get_id() const {
+        return course_id;
+    }
+    
+    // FIX: Public Getter to access private data
+    inline int get_enrolled_students() const { return enrolled_students.load(); }
+    inline int get_capacity() const { return capacity; }
+    inline const std::string& get_title() const { return title; }
+
+    // MODULE 4: Constant Member Function (cannot modify the object's state)
+    void display_details() const;
+
+    void increment_enrollment() {
+        if (!try_reserve_seat()) {
+            // MODULE 5: Exception Handling (Throwing an exception)
+            throw SystemException("Course is already full. Enrollment failed.");
+        }
+    }
+
+    // Lock-free seat reservation (compare-and-swap loop). Safe to call from many
+    // threads: exactly as many calls succeed as there were free seats.
+    bool try_reserve_seat() {
+        int current = enrolled_students.load(std::memory_order_relaxed);
+        while (current < capacity) {
+            if (enrolled_students.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel,
+                                                        std::memory_order_relaxed)) {
+                UMS_COUNT_ENROLLMENT(metrics_slot, 1, 0);
+                return true;
+            }
+        }
+        UMS_COUNT_ENROLLMENT(metrics_slot, 1, 1);
+        return false;
+    }
+
+    // Reserves up to 'count' seats in one CAS and returns how many were granted
+    int try_reserve_seats(int count) {
+        int current = enrolled_students.load(std::memory_order_relaxed);
+        while (true) {
+            int granted = std::min(count, capacity - current);
+            if (granted <= 0) {
+                UMS_COUNT_ENROLLMENT(metrics_slot, static_cast<uint64_t>(std::max(count, 0)), static_cast<uint64_t>(std::max(count, 0)));
+                return 0;
+            }
+            if (enrolled_students.compare_exchange_weak(current, current + granted, std::memory_order_acq_rel,
+                                                        std::memory_order_relaxed)) {
+                UMS_COUNT_ENROLLMENT(metrics_slot, static_cast<uint64_t>(count), static_cast<uint64_t>(count - granted));
+                return granted;
+            }
+        }
+    }
+
+    // Gives back a seat taken by try_reserve_seat()
+    void release_seat() {
+        enrolled_students.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    // MODULE 4: Static Member Function
+    static int get_total_courses() {
+        return total_courses;
+    }
+
+    // MODULE 4: Operator Overloading (Overloading the insertion operator <<)
+    // Declared as a friend function to allow access to private members
+    friend std::ostream& operator<<(std::ostream& os, const Course& course);
+
+    // File Handling helper for saving (generated from RecordSchema<Course>)
+    std::string to_string() const;
+};
+
+// MODULE 4: Initialization of Static Data Member
+int Course::total_courses = 0;
+
+// MODULE 4: Operator Overloading implementation
+std::ostream& operator<<(std::ostream& os, const Course& course) {
+    os << "Code: " << course.course_id
+       << " | Title: " << course.title
+       << " | Enrollment: " << course.enrolled_students.load() << "/" << course.capacity;
+    return os;
+}
+
+// MODULE 1: Defining Member Function Outside Class
+void Course::display_details() const {
+    std::cout << "Course Details:\n" << *this << std::endl;
+}
+
+// =====================================================================
+// MODULE 3, 4: Abstract Base Class
+// Demonstrates Pure Virtual Function and the start of Polymorphism
+// =====================================================================
+class User {
+protected:
+    // Protected Access Specifier (accessible by derived classes)
+    int user_id;
+    std::string name;
+
+public:
+    // Constructor
+    User(int id, std::string n) : user_id(id), name(n) {}
+
+    // Copy and move (declared explicitly because the virtual destructor suppresses the implicit moves)
+    User(const User&) = default;
+    User(User&&) noexcept = default;
+    User& operator=(const User&) = default;
+    User& operator=(User&&) = default;
+
+    // MODULE 3: Pure Virtual Function (Makes User an Abstract Class)
+    virtual void display_details() const = 0;
+
+    // Courses taken (Student) or taught (Faculty)
+    virtual size_t course_count() const = 0;
+
+    // Appends the user's record line, as written by its RecordSchema (no newline)
+    virtual void append_record(std::string& out) const = 0;
+
+    // MODULE 4: Virtual Destructor (Essential for proper cleanup in inheritance hierarchies)
+    virtual ~User() {}
+
+    // Inline Function
+    inline int get_id() const { return user_id; }
+    inline const std::string& get_name() const { return name; }
+};
+
+// Non-owning link from a Student to the EnrollmentIndex that tracks it.
+// A copy starts unlinked (the copy is not in the indexed list); a move
+// keeps the link, because RecordList moves records when its vector grows
+// or a record is removed.
+class EnrollmentIndexLink {
+private:
+    EnrollmentIndex* index = nullptr;
+
+public:
+    EnrollmentIndexLink() {}
+    EnrollmentIndexLink(const EnrollmentIndexLink&) {}
+    EnrollmentIndexLink(EnrollmentIndexLink&& other) noexcept : index(other.index) { other.index = nullptr; }
+    EnrollmentIndexLink& operator=(const EnrollmentIndexLink&) { return *this; }
+    EnrollmentIndexLink& operator=(EnrollmentIndexLink&& other) noexcept {
+        index = other.index;
+        other.index = nullptr;
+        return *this;
+    }
+
+    inline void attach(EnrollmentIndex* to) { index = to; }
+    inline EnrollmentIndex* get() const { return index; }
+
+    // Defined after EnrollmentIndex
+    void enrolled(int student_id, int course_id) const;
+    void unenrolled(int student_id, int course_id) const;
+};
+
+// =====================================================================
+// MODULE 1, 3, 4: Student Class
+// Demonstrates Inheritance, Static Members, Const, Friend, Overloading
+// =====================================================================
+class Student final : public User {
+private:
+    // Data Members
+    static int next_roll_number; // MODULE 4: Static Data Member (for auto-incrementing ID)
+    int roll_number;
+    std::vector<int> enrolled_course_ids;
+    // Mutable: EnrollmentIndex attaches itself through RecordList's const on_insert() hook
+    mutable EnrollmentIndexLink enrollment_index;
+
+    // MODULE 2: Friend Class Declaration
+    friend class DatabaseManager; // Allows DatabaseManager to access private members
+    friend class EnrollmentEngine; // Publishes concurrent enrollments back into the student
+    friend class StudentTable;     // Rebuilds Student objects from the columnar layout
+    friend class EnrollmentIndex;  // Attaches to / detaches from the student
+    friend class LazyStudentStore; // Reconciles the roll counter after indexing the file
+
+    // Every change to enrolled_course_ids goes through these two, so an attached EnrollmentIndex stays current
+    void add_course_id(int course_id) {
+        enrolled_course_ids.push_back(course_id);
+        enrollment_index.enrolled(user_id, course_id);
+    }
+
+    bool remove_course_id(int course_id) {
+        auto it = std::find(enrolled_course_ids.begin(), enrolled_course_ids.end(), course_id);
+        if (it == enrolled_course_ids.end()) return false;
+        enrolled_course_ids.erase(it);
+        enrollment_index.unenrolled(user_id, course_id);
+        return true;
+    }
+
+    // Used by the bulk loaders: builds a Student without touching the static
+    // roll counter, which is reconciled once after the load instead
+    struct BulkLoadTag {};
+    Student(BulkLoadTag, std::string_view n, int id, int roll) : User(id, std::string(n)), roll_number(roll) {}
+
+    static void reconcile_roll_counter(int max_roll) {
+        if (max_roll >= next_roll_number) {
+            next_roll_number = max_roll + 1;
+        }
+    }
+
+public:
+    // MODULE 2: Constructor (Initializes User base class, uses 'this' pointer)
+    Student(std::string n, int id) : User(id, n), roll_number(next_roll_number++) {
+        // Explicit use of 'this' pointer
+        this->user_id = id;
+        UMS_LOG(LogLevel::Debug) << "Student " << n << " created with Roll No: " << roll_number;
+    }
+
+    // Constructor for loading from file (without auto-incrementing static counter)
+    Student(std::string n, int id, int roll) : User(id, n), roll_number(roll) {
+        // Ensure static counter is up-to-date
+        if (roll >= next_roll_number) {
+            next_roll_number = roll + 1;
+        }
+    }
+
+    // Copy and move (declared explicitly alongside the user-declared destructor)
+    Student(const Student&) = default;
+    Student(Student&&) noexcept = default;
+    Student& operator=(const Student&) = default;
+    Student& operator=(Student&&) = default;
+
+    // MODULE 2: Destructor
+    ~Student() {
+        UMS_LOG(LogLevel::Debug) << "Student object for " << name << " (Roll: " << roll_number << ") destroyed.";
+    }
+
+    // MODULE 3, 4: Function Overriding (Implements Pure Virtual Function)
+    // Demonstrates Dynamic Binding/Runtime Polymorphism
+    void display_details() const override {
+        std::cout << "--- Student Details ---" << std::endl;
+        std::cout << "ID (User): " << user_id << std::endl;
+        std::cout << "Roll No: " << roll_number << std::endl;
+        std::cout << "Name: " << name << std::endl;
+        std::cout << "Enrolled Courses: " << enrolled_course_ids.size() << std::endl;
+    }
+
+    size_t course_count() const override { return enrolled_course_ids.size(); }
+    void append_record(std::string& out) const override;
+
+    // MODULE 2: Function Overloading (enroll by ID)
+    void enroll(int course_id) {
+        UMS_TIME_SAMPLED(Timer::StudentEnroll);
+        if (!simd_contains(enrolled_course_ids, course_id)) {
+            add_course_id(course_id);
+            UMS_LOG(LogLevel::Info) << name << " enrolled in course ID " << course_id << " (via ID).";
+        } else {
+            UMS_LOG(LogLevel::Info) << name << " is already enrolled in course ID " << course_id << ".";
+        }
+    }
+
+    // MODULE 2: Function Overloading (enroll by Course object reference)
+    void enroll(Course& course) {
+        UMS_TIME_SAMPLED(Timer::StudentEnroll);
+        // MODULE 2: Reference usage
+        int course_id = course.get_id();
+        if (!simd_contains(enrolled_course_ids, course_id)) {
+            try {
+                // Throws an exception if the course is full
+                course.increment_enrollment();
+                add_course_id(course_id);
+                UMS_LOG(LogLevel::Info) << name << " successfully enrolled in " << course.get_id() << " (via Object).";
+            } catch (const SystemException& e) {
+                // MODULE 5: Exception Handling (Catching the exception)
+                UMS_LOG(LogLevel::Error) << "ENROLLMENT ERROR: " << e.what();
+            }
+        } else {
+            UMS_LOG(LogLevel::Info) << name << " is already enrolled in course ID " << course_id << ".";
+        }
+    }
+
+    // Drops a course by ID (the course's seat count is not touched). Returns false if not enrolled.
+    bool unenroll(int course_id) {
+        if (!remove_course_id(course_id)) {
+            UMS_LOG(LogLevel::Info) << name << " is not enrolled in course ID " << course_id << ".";
+            return false;
+        }
+        UMS_LOG(LogLevel::Info) << name << " unenrolled from course ID " << course_id << ".";
+        return true;
+    }
+
+    // Drops a course and gives its seat back
+    bool unenroll(Course& course) {
+        if (!unenroll(course.get_id())) return false;
+        course.release_seat();
+        return true;
+    }
+
+    inline int get_roll_number() const { return roll_number; }
+    inline const std::vector<int>& get_enrolled_course_ids() const { return enrolled_course_ids; }
+
+    // MODULE 4: Static Member Function
+    static int get_total_students() {
+        return next_roll_number - 1;
+    }
+
+    // File Handling helper for saving (generated from RecordSchema<Student>)
+    std::string to_string() const;
+};
+
+// MODULE 4: Initialization of Static Data Member
+int Student::next_roll_number = 1001;
+
+// =====================================================================
+// MODULE 3: Faculty Class (Simple Inheritance Demo)
+// =====================================================================
+class Faculty final : public User {
+private:
+    std::string department;
+    // MODULE 1: Array of Objects (using Course objects)
+    std::vector<Course*> courses_taught; // MODULE 2: Demonstrating Dynamic Memory with pointers
+
+public:
+    // Constructor
+    Faculty(std::string n, int id, std::string dept) : User(id, n), department(dept) {
+        // Initial setup
+    }
+
+    // MODULE 3, 4: Function Overriding (Implements Pure Virtual Function)
+    void display_details() const override {
+        std::cout << "--- Faculty Details ---" << std::endl;
+        std::cout << "ID: " << user_id << std::endl;
+        std::cout << "Name: " << name << std::endl;
+        std::cout << "Department: " << department << std::endl;
+        std::cout << "Courses Taught: " << courses_taught.size() << std::endl;
+    }
+
+    size_t course_count() const override { return courses_taught.size(); }
+    void append_record(std::string& out) const override;
+
+    // Copy and move (declared because the destructor below suppresses the implicit moves)
+    Faculty(const Faculty&) = default;
+    Faculty(Faculty&&) noexcept = default;
+    Faculty& operator=(const Faculty&) = default;
+    Faculty& operator=(Faculty&&) = default;
+
+    inline const std::string& get_department() const { return department; }
+    inline const std::vector<Course*>& get_courses_taught() const { return courses_taught; }
+
+    // id|name|department|course IDs taught (generated from RecordSchema<Faculty>)
+    std::string to_string() const;
+
+    // MODULE 2: Dynamic Memory Allocation (using new)
+    void assign_course(Course* course_ptr) {
+        if (course_ptr) {
+            courses_taught.push_back(course_ptr);
+            UMS_LOG(LogLevel::Info) << name << " assigned course " << course_ptr->get_id() << ".";
+        }
+    }
+
+    // MODULE 2: Destructor (Essential for cleaning up dynamically allocated resources)
+    ~Faculty() {
+        // Since the Course objects are managed externally, we only clear the pointers here.
+        // If Faculty owned the courses, we would delete the pointers in this loop.
+        courses_taught.clear();
+        UMS_LOG(LogLevel::Debug) << "Faculty object for " << name << " destroyed.";
+    }
+};
+
+// =====================================================================
+// Course -> Student Reverse Index
+// A Student lists its own course IDs; EnrollmentIndex keeps the other
+// direction, one posting list of student IDs per course, so a roster
+// costs O(roster size) instead of a scan over every student.
+//  - It plugs into RecordList<Student> as a secondary index, so loading,
+//    add_record() and remove_record() keep it current.
+//  - It attaches itself to every indexed Student, so Student::enroll(),
+//    unenroll() and EnrollmentEngine::publish() update it incrementally.
+//  - Posting lists are sorted ID vectors. Bulk inserts append and sort
+//    once on the next query, so indexing N students costs O(N log N).
+// Only one EnrollmentIndex can track a given list. Like RecordList, it
+// must not be queried and modified from different threads at once.
+// =====================================================================
+class EnrollmentIndex : public SecondaryIndex<Student> {
+private:
+    struct PostingList {
+        std::vector<int> ids;
+        bool sorted = true; // False after out-of-order bulk appends
+    };
+    // Mutable: queries sort a posting list lazily
+    mutable std::unordered_map<int, PostingList> rosters;
+
+    static void normalize(PostingList& list) {
+        if (list.sorted) return;
+        std::sort(list.ids.begin(), list.ids.end());
+        list.sorted = true;
+    }
+
+    // Bulk path: O(1) append, sorted later
+    void append(int course_id, int student_id) {
+        PostingList& list = rosters[course_id];
+        if (!list.ids.empty() && student_id < list.ids.back()) list.sorted = false;
+        list.ids.push_back(student_id);
+    }
+
+public:
+    void on_insert(const Student& student) override {
+        student.enrollment_index.attach(this);
+        for (int course_id : student.enrolled_course_ids) append(course_id, student.get_id());
+    }
+
+    void on_erase(const Student& student) override {
+        for (int course_id : student.enrolled_course_ids) on_unenroll(student.get_id(), course_id);
+        if (student.enrollment_index.get() == this) student.enrollment_index.attach(nullptr);
+    }
+
+    void clear() override { rosters.clear(); }
+
+    // Incremental updates (called through the Student's link)
+    void on_enroll(int student_id, int course_id) {
+        PostingList& list = rosters[course_id];
+        normalize(list);
+        list.ids.insert(std::upper_bound(list.ids.begin(), list.ids.end(), student_id), student_id);
+    }
+
+    void on_unenroll(int student_id, int course_id) {
+        auto found = rosters.find(course_id);
+        if (found == rosters.end()) return;
+        PostingList& list = found->second;
+        normalize(list);
+        auto it = std::lower_bound(list.ids.begin(), list.ids.end(), student_id);
+        if (it != list.ids.end() && *it == student_id) list.ids.erase(it);
+        if (list.ids.empty()) rosters.erase(found);
+    }
+
+    // Sorted IDs of the students enrolled in 'course_id'. An ID appears once per
+    // enrolled record, so it repeats only if the list holds duplicate IDs.
+    const std::vector<int>& roster(int course_id) const {
+        static const std::vector<int> empty;
+        auto found = rosters.find(course_id);
+        if (found == rosters.end()) return empty;
+        normalize(found->second);
+        return found->second.ids;
+    }
+
+    inline size_t roster_size(int course_id) const { return roster(course_id).size(); }
+
+    bool is_enrolled(int student_id, int course_id) const {
+        const std::vector<int>& ids = roster(course_id);
+        return std::binary_search(ids.begin(), ids.end(), student_id);
+    }
+
+    // Sorted IDs of every student taking at least one course the faculty member teaches
+    std::vector<int> students_of(const Faculty& faculty) const {
+        std::vector<int> result, merged;
+        for (const Course* course : faculty.get_courses_taught()) {
+            const std::vector<int>& ids = roster(course->get_id());
+            merged.clear();
+            std::set_union(result.begin(), result.end(), ids.begin(), ids.end(), std::back_inserter(merged));
+            result.swap(merged);
+        }
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    // Faculty members who teach at least one of the student's courses
+    static std::vector<Faculty*> faculty_of(const Student& student, const std::vector<Faculty*>& faculty) {
+        std::vector<Faculty*> result;
+        for (Faculty* member : faculty) {
+            for (const Course* course : member->get_courses_taught()) {
+                if (simd_contains(student.get_enrolled_course_ids(), course->get_id())) {
+                    result.push_back(member);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    inline size_t course_count() const { return rosters.size(); }
+
+    size_t entry_count() const {
+        size_t total = 0;
+        for (auto& entry : rosters) {
+            normalize(entry.second);
+            total += entry.second.ids.size();
+        }
+        return total;
+    }
+
+    // Refills every posting list from 'students' (the list this index is
+    // added to) on the pool: each task collects the (course, student) pairs
+    // of one slice of the records, bucketed by course, then one task per
+    // bucket builds and sorts that bucket's posting lists.
+    void rebuild(const RecordList<Student>& students, ThreadPool& pool = ThreadPool::shared()) {
+        const std::vector<Student>& records = students.get_records();
+        const size_t buckets = pool.size() * 4;
+        const size_t slice = std::max<size_t>(1024, records.size() / (pool.size() * 8) + 1);
+        const size_t slices = (records.size() + slice - 1) / slice;
+
+        std::vector<std::vector<std::pair<int, int>>> pairs(slices * buckets); // [slice][bucket]
+        pool.parallel_for(0, slices, [&](size_t lo, size_t hi) {
+            for (size_t s = lo; s < hi; ++s) {
+                for (size_t i = s * slice; i < std::min(records.size(), (s + 1) * slice); ++i) {
+                    const Student& student = records[i];
+                    student.enrollment_index.attach(this);
+                    for (int course_id : student.enrolled_course_ids) {
+                        pairs[s * buckets + static_cast<uint32_t>(course_id) % buckets].emplace_back(course_id, student.get_id());
+                    }
+                }
+            }
+        }, 1);
+
+        std::vector<std::unordered_map<int, PostingList>> built(buckets);
+        pool.parallel_for(0, buckets, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; ++b) {
+                for (size_t s = 0; s < slices; ++s) {
+                    for (const std::pair<int, int>& entry : pairs[s * buckets + b]) {
+                        PostingList& list = built[b][entry.first];
+                        if (!list.ids.empty() && entry.second < list.ids.back()) list.sorted = false;
+                        list.ids.push_back(entry.second);
+                    }
+                }
+                for (auto& entry : built[b]) normalize(entry.second);
+            }
+        }, 1);
+
+        rosters.clear();
+        for (auto& bucket : built) rosters.merge(bucket); // Moves the nodes, no copying
+    }
+
+    // Rebuilds the expected rosters from the student side and compares.
+    // Returns true if they match; otherwise describes each difference in 'problems' (if given).
+    bool check_consistency(const RecordList<Student>& students, std::vector<std::string>* problems = nullptr) const {
+        std::unordered_map<int, std::vector<int>> expected;
+        for (const Student& s : students.get_records()) {
+            for (int course_id : s.get_enrolled_course_ids()) expected[course_id].push_back(s.get_id());
+        }
+        bool consistent = true;
+        auto report = [&](const std::string& text) {
+            consistent = false;
+            if (problems) problems->push_back(text);
+        };
+        for (auto& entry : expected) {
+            std::vector<int>& want = entry.second;
+            std::sort(want.begin(), want.end());
+            const std::vector<int>& have = roster(entry.first);
+            std::vector<int> missing, extra;
+            std::set_difference(want.begin(), want.end(), have.begin(), have.end(), std::back_inserter(missing));
+            std::set_difference(have.begin(), have.end(), want.begin(), want.end(), std::back_inserter(extra));
+            for (int id : missing) report("course " + std::to_string(entry.first) + ": student " + std::to_string(id) + " missing from roster");
+            for (int id : extra) report("course " + std::to_string(entry.first) + ": student " + std::to_string(id) + " not enrolled");
+        }
+        for (const auto& entry : rosters) {
+            if (expected.count(entry.first) == 0) {
+                for (int id : entry.second.ids) {
+                    report("course " + std::to_string(entry.first) + ": student " + std::to_string(id) + " not enrolled");
+                }
+            }
+        }
+        return consistent;
+    }
+};
+
+inline void EnrollmentIndexLink::enrolled(int student_id, int course_id) const {
+    if (index) index->on_enroll(student_id, course_id);
+}
+
+inline void EnrollmentIndexLink::unenrolled(int student_id, int course_id) const {
+    if (index) index->on_unenroll(student_id, course_id);
+}
+
+// One (student, course) pair for EnrollmentEngine::enroll_batch()
+struct EnrollmentRequest {
+    int student_id;
+    int course_id;
+};
+
+// Per-request outcome of a batch enrollment (cheap result codes instead of exceptions)
+enum class EnrollmentResult : uint8_t {
+    Enrolled,
+    AlreadyEnrolled,
+    DuplicateInBatch,
+    CourseFull,
+    UnknownStudent,
+    UnknownCourse
+};
+
+inline const char* enrollment_result_name(EnrollmentResult result) {
+    switch (result) {
+        case EnrollmentResult::Enrolled: return "enrolled";
+        case EnrollmentResult::AlreadyEnrolled: return "already enrolled";
+        case EnrollmentResult::DuplicateInBatch: return "duplicate in batch";
+        case EnrollmentResult::CourseFull: return "course full";
+        case EnrollmentResult::UnknownStudent: return "unknown student";
+        case EnrollmentResult::UnknownCourse: return "unknown course";
+    }
+    return "?";
+}
+
+// =====================================================================
+// Concurrent Enrollment Engine
+// Lets many request threads enroll students at the same time without a
+// global mutex:
+//  - seats are reserved with Course::try_reserve_seat() (atomic CAS), so two
+//    threads can never both take the last seat;
+//  - each student's enrolled courses are an immutable sorted vector behind a
+//    shared_ptr. Readers atomically load the current version; writers copy,
+//    insert and compare-and-swap the new version in (copy-on-write).
+// The student and course lists must not be resized while the engine is in use.
+// =====================================================================
+class EnrollmentEngine {
+private:
+    using CourseSet = std::vector<int>; // Sorted course IDs
+
+    struct StudentSlot {
+        Student* student;
+        std::shared_ptr<const CourseSet> courses; // Only touched through std::atomic_load/store/CAS
+    };
+
+    std::unordered_map<int, StudentSlot> students; // Built once; never rehashed during enrollment
+    std::unordered_map<int, Course*> courses;
+
+    StudentSlot& slot_of(int student_id) {
+        auto it = students.find(student_id);
+        if (it == students.end()) {
+            throw SystemException("Unknown student ID " + std::to_string(student_id) + ". Enrollment failed.");
+        }
+        return it->second;
+    }
+
+    Course& course_of(int course_id) {
+        auto it = courses.find(course_id);
+        if (it == courses.end()) {
+            throw SystemException("Unknown course ID " + std::to_string(course_id) + ". Enrollment failed.");
+        }
+        return *it->second;
+    }
+
+    // Copy-on-write insert of one course ID. Returns false if it was already there.
+    static bool add_course(StudentSlot& slot, int course_id) {
+        std::shared_ptr<const CourseSet> current = std::atomic_load(&slot.courses);
+        while (true) {
+            auto pos = std::lower_bound(current->begin(), current->end(), course_id);
+            if (pos != current->end() && *pos == course_id) return false;
+            auto next = std::make_shared<CourseSet>(*current);
+            next->insert(next->begin() + (pos - current->begin()), course_id);
+            std::shared_ptr<const CourseSet> desired = std::move(next);
+            // On failure 'current' is refreshed with the version another thread published
+            if (std::atomic_compare_exchange_weak(&slot.courses, &current, desired)) return true;
+        }
+    }
+
+public:
+    EnrollmentEngine(RecordList<Student>& student_list, const std::vector<Course*>& course_list) {
+        students.reserve(student_list.count());
+        for (Student& s : student_list.get_records()) {
+            auto set = std::make_shared<CourseSet>(s.enrolled_course_ids.begin(), s.enrolled_course_ids.end());
+            std::sort(set->begin(), set->end());
+            students[s.get_id()] = StudentSlot{&s, set};
+        }
+        for (Course* c : course_list) {
+            courses[c->get_id()] = c;
+        }
+    }
+
+    // Thread-safe enrollment. Returns true if the student was enrolled, false if
+    // they already were. Throws SystemException if the course is full.
+    // The seat is reserved before the membership is published, so a pair is
+    // never visible without its seat. A racing duplicate that loses the
+    // publish gives its seat back (other students may briefly see the course
+    // as full meanwhile).
+    bool enroll(int student_id, int course_id) {
+        UMS_TIME_SAMPLED(Timer::EngineEnroll);
+        StudentSlot& slot = slot_of(student_id);
+        Course& course = course_of(course_id);
+
+        if (!course.try_reserve_seat()) {
+            std::shared_ptr<const CourseSet> current = std::atomic_load(&slot.courses);
+            if (std::binary_search(current->begin(), current->end(), course_id)) return false;
+            throw SystemException("Course is already full. Enrollment failed.");
+        }
+        if (!add_course(slot, course_id)) {
+            course.release_seat();
+            return false;
+        }
+        return true;
+    }
+
+    // Applies many enrollments at once. Requests are grouped by course so each
+    // course's seats are reserved with a single CAS; duplicates inside the
+    // batch and existing enrollments are filtered with sorted lookups. When a
+    // course runs out of seats, earlier requests win. Safe to run alongside
+    // enroll() on other threads.
+    std::vector<EnrollmentResult> enroll_batch(const EnrollmentRequest* requests, size_t count) {
+        UMS_TIME(Timer::EngineEnrollBatch);
+        std::vector<EnrollmentResult> results(count, EnrollmentResult::Enrolled);
+
+        // Sort request indices by (course, student, position) so a course's requests are
+        // contiguous and duplicate pairs are adjacent with the earliest one first
+        std::vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; ++i) order[i] = static_cast<uint32_t>(i);
+        std::sort(order.begin(), order.end(), [requests](uint32_t a, uint32_t b) {
+            if (requests[a].course_id != requests[b].course_id) return requests[a].course_id < requests[b].course_id;
+            if (requests[a].student_id != requests[b].student_id) return requests[a].student_id < requests[b].student_id;
+            return a < b;
+        });
+
+        // Candidates end up grouped by course, each group in request order
+        struct Candidate {
+            StudentSlot* slot;
+            Course* course;
+            uint32_t request;
+            bool seated;   // A seat was reserved for it
+            bool claimed;  // Our publish added the pair (it was not already there)
+        };
+        std::vector<Candidate> candidates;
+        std::vector<size_t> course_groups; // Start of each course's candidates
+
+        for (size_t group = 0; group < count;) {
+            int course_id = requests[order[group]].course_id;
+            size_t group_end = group;
+            while (group_end < count && requests[order[group_end]].course_id == course_id) group_end++;
+
+            auto course_it = courses.find(course_id);
+            size_t group_start = candidates.size();
+            for (size_t k = group; k < group_end; ++k) {
+                uint32_t index = order[k];
+                const EnrollmentRequest& request = requests[index];
+                if (course_it == courses.end()) {
+                    results[index] = EnrollmentResult::UnknownCourse;
+                } else if (k > group && requests[order[k - 1]].student_id == request.student_id) {
+                    results[index] = EnrollmentResult::DuplicateInBatch;
+                } else {
+                    auto student_it = students.find(request.student_id);
+                    if (student_it == students.end()) {
+                        results[index] = EnrollmentResult::UnknownStudent;
+                        continue;
+                    }
+                    std::shared_ptr<const CourseSet> current = std::atomic_load(&student_it->second.courses);
+                    if (std::binary_search(current->begin(), current->end(), course_id)) {
+                        results[index] = EnrollmentResult::AlreadyEnrolled;
+                    } else {
+                        candidates.push_back(Candidate{&student_it->second, course_it->second, index, false, false});
+                    }
+                }
+            }
+            if (candidates.size() > group_start) {
+                // Earlier requests get the seats
+                std::sort(candidates.begin() + group_start, candidates.end(),
+                          [](const Candidate& x, const Candidate& y) { return x.request < y.request; });
+                course_groups.push_back(group_start);
+            }
+            group = group_end;
+        }
+        course_groups.push_back(candidates.size());
+
+        // As in enroll(): seats first, with a single CAS per course, so a pair
+        // is only published once it holds a seat
+        for (size_t g = 0; g + 1 < course_groups.size(); ++g) {
+            int wanted = static_cast<int>(course_groups[g + 1] - course_groups[g]);
+            int granted = candidates[course_groups[g]].course->try_reserve_seats(wanted);
+            for (size_t k = course_groups[g]; k < course_groups[g + 1] && granted > 0; ++k, --granted) {
+                candidates[k].seated = true;
+            }
+        }
+
+        // Publish the seated pairs. One copy-on-write update covers all of a
+        // student's new courses.
+        std::vector<uint32_t> by_student;
+        by_student.reserve(candidates.size());
+        for (size_t k = 0; k < candidates.size(); ++k) {
+            if (candidates[k].seated) by_student.push_back(static_cast<uint32_t>(k));
+        }
+        std::stable_sort(by_student.begin(), by_student.end(),
+                         [&](uint32_t x, uint32_t y) { return candidates[x].slot < candidates[y].slot; });
+        for (size_t first = 0; first < by_student.size();) {
+            size_t last = first;
+            StudentSlot& slot = *candidates[by_student[first]].slot;
+            while (last < by_student.size() && candidates[by_student[last]].slot == &slot) last++;
+
+            std::shared_ptr<const CourseSet> current = std::atomic_load(&slot.courses);
+            while (true) {
+                auto next = std::make_shared<CourseSet>(*current);
+                for (size_t k = first; k < last; ++k) {
+                    Candidate& c = candidates[by_student[k]];
+                    int course_id = c.course->get_id();
+                    auto pos = std::lower_bound(next->begin(), next->end(), course_id);
+                    c.claimed = pos == next->end() || *pos != course_id; // Else enroll() on another thread won
+                    if (c.claimed) next->insert(pos, course_id);
+                }
+                std::shared_ptr<const CourseSet> desired = std::move(next);
+                if (std::atomic_compare_exchange_weak(&slot.courses, &current, desired)) break;
+            }
+            first = last;
+        }
+
+        // Report, and give back the seats of pairs another thread published first
+        for (const Candidate& c : candidates) {
+            if (!c.seated) {
+                results[c.request] = EnrollmentResult::CourseFull;
+            } else if (!c.claimed) {
+                results[c.request] = EnrollmentResult::AlreadyEnrolled;
+                c.course->release_seat();
+            }
+        }
+        return results;
+    }
+
+    std::vector<EnrollmentResult> enroll_batch(const std::vector<EnrollmentRequest>& requests) {
+        return enroll_batch(requests.data(), requests.size());
+    }
+
+    // Lock-free reader, safe while other threads enroll
+    bool is_enrolled(int student_id, int course_id) {
+        std::shared_ptr<const CourseSet> current = std::atomic_load(&slot_of(student_id).courses);
+        return std::binary_search(current->begin(), current->end(), course_id);
+    }
+
+    // Consistent (possibly slightly stale) view of one student's courses
+    std::shared_ptr<const CourseSet> courses_of(int student_id) {
+        return std::atomic_load(&slot_of(student_id).courses);
+    }
+
+    // Copies the concurrent sets back into the Student objects (keeping their
+    // original order). Call once no enrollments are in flight.
+    void publish() {
+        for (auto& entry : students) {
+            std::shared_ptr<const CourseSet> current = std::atomic_load(&entry.second.courses);
+            Student& student = *entry.second.student;
+            for (int course_id : *current) {
+                if (!simd_contains(student.enrolled_course_ids, course_id)) {
+                    student.add_course_id(course_id);
+                }
+            }
+        }
+    }
+};
+
+// =====================================================================
+// Columnar Student Table (structure of arrays)
+// Analytics scans over RecordList<Student> jump between Student objects,
+// their heap-allocated names and their separately allocated course
+// vectors. StudentTable stores the same data as contiguous columns:
+// IDs, rolls, name offsets into one character pool, and all enrolled
+// course IDs in one CSR array (offsets + values).
+// =====================================================================
+class StudentTable {
+private:
+    std::vector<int> ids;
+    std::vector<int> rolls;
+    std::vector<uint32_t> name_offsets;   // size() + 1 entries into 'names'
+    std::string names;
+    std::vector<uint32_t> course_offsets; // size() + 1 entries into 'course_values' (CSR)
+    std::vector<int> course_values;
+
+    static uint32_t checked_offset(size_t offset) {
+        if (offset > UINT32_MAX) {
+            throw SystemException("StudentTable column exceeds 4 GB.");
+        }
+        return static_cast<uint32_t>(offset);
+    }
+
+public:
+    StudentTable() : name_offsets(1, 0), course_offsets(1, 0) {}
+
+    static StudentTable from_records(RecordList<Student>& student_list) {
+        StudentTable table;
+        const std::vector<Student>& students = student_list.get_records();
+        size_t name_bytes = 0, course_count = 0;
+        for (const Student& s : students) {
+            name_bytes += s.get_name().size();
+            course_count += s.enrolled_course_ids.size();
+        }
+        table.ids.reserve(students.size());
+        table.rolls.reserve(students.size());
+        table.names.reserve(name_bytes);
+        table.course_values.reserve(course_count);
+        table.name_offsets.reserve(students.size() + 1);
+        table.course_offsets.reserve(students.size() + 1);
+        for (const Student& s : students) {
+            table.append(s.get_id(), s.get_name(), s.get_roll_number(), s.enrolled_course_ids.data(),
+                         s.enrolled_course_ids.size());
+        }
+        return table;
+    }
+
+    void append(int id, std::string_view name, int roll, const int* courses, size_t course_count) {
+        ids.push_back(id);
+        rolls.push_back(roll);
+        names.append(name.data(), name.size());
+        name_offsets.push_back(checked_offset(names.size()));
+        course_values.insert(course_values.end(), courses, courses + course_count);
+        course_offsets.push_back(checked_offset(course_values.size()));
+    }
+
+    // Rebuilds Student objects (appended to 'student_list')
+    void to_records(RecordList<Student>& student_list) const {
+        student_list.reserve(student_list.count() + size());
+        int max_roll = 0;
+        for (size_t i = 0; i < size(); ++i) {
+            Student s(Student::BulkLoadTag{}, name(i), ids[i], rolls[i]);
+            s.enrolled_course_ids.assign(courses_begin(i), courses_end(i));
+            student_list.add_record(std::move(s), false);
+            max_roll = std::max(max_roll, rolls[i]);
+        }
+        Student::reconcile_roll_counter(max_roll);
+    }
+
+    inline size_t size() const { return ids.size(); }
+    inline int id(size_t row) const { return ids[row]; }
+    inline int roll(size_t row) const { return rolls[row]; }
+    inline std::string_view name(size_t row) const {
+        return std::string_view(names.data() + name_offsets[row], name_offsets[row + 1] - name_offsets[row]);
+    }
+    inline const int* courses_begin(size_t row) const { return course_values.data() + course_offsets[row]; }
+    inline const int* courses_end(size_t row) const { return course_values.data() + course_offsets[row + 1]; }
+    inline size_t course_count(size_t row) const { return course_offsets[row + 1] - course_offsets[row]; }
+
+    // Whole-column access for scans
+    inline const std::vector<int>& all_course_ids() const { return course_values; }
+
+    // One row, read through the same getters as Student, so RecordCodec<Student> can write it
+    class Row {
+    private:
+        const StudentTable& table;
+        size_t index;
+
+    public:
+        struct CourseRange {
+            const int* first;
+            const int* last;
+            inline const int* begin() const { return first; }
+            inline const int* end() const { return last; }
+            inline size_t size() const { return static_cast<size_t>(last - first); }
+        };
+
+        Row(const StudentTable& t, size_t i) : table(t), index(i) {}
+        inline int get_id() const { return table.id(index); }
+        inline std::string_view get_name() const { return table.name(index); }
+        inline int get_roll_number() const { return table.roll(index); }
+        inline CourseRange get_enrolled_course_ids() const {
+            return CourseRange{table.courses_begin(index), table.courses_end(index)};
+        }
+    };
+
+    inline Row row(size_t index) const { return Row(*this, index); }
+
+    // (course ID, number of enrolled students), sorted by course ID.
+    // One sequential pass over the CSR values array.
+    std::vector<std::pair<int, size_t>> count_per_course() const {
+        return simd_histogram(course_values.data(), course_values.size());
+    }
+
+    // Same report, one histogram per slice of the values array on the pool, merged at the end
+    std::vector<std::pair<int, size_t>> count_per_course(ThreadPool& pool) const {
+        const size_t slice = std::max<size_t>(1 << 16, course_values.size() / (pool.size() * 4) + 1);
+        const size_t slices = (course_values.size() + slice - 1) / slice;
+        std::vector<std::vector<std::pair<int, size_t>>> partial(slices);
+        pool.parallel_for(0, slices, [&](size_t lo, size_t hi) {
+            for (size_t s = lo; s < hi; ++s) {
+                size_t first = s * slice, last = std::min(course_values.size(), first + slice);
+                partial[s] = simd_histogram(course_values.data() + first, last - first);
+            }
+        }, 1);
+
+        std::map<int, size_t> merged;
+        for (const auto& counts : partial) {
+            for (const auto& entry : counts) merged[entry.first] += entry.second;
+        }
+        return std::vector<std::pair<int, size_t>>(merged.begin(), merged.end());
+    }
+
+    // Sorted IDs of the students enrolled in a course
+    std::vector<int> roster(int course_id) const {
+        const SimdKernels& kernels = simd_kernels();
+        std::vector<int> result;
+        for (size_t row = 0; row < size(); ++row) {
+            if (kernels.contains(courses_begin(row), course_count(row), course_id)) result.push_back(ids[row]);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // Same report, rows scanned in parallel slices on the pool
+    std::vector<int> roster(int course_id, ThreadPool& pool) const {
+        const SimdKernels& kernels = simd_kernels();
+        const size_t slice = std::max<size_t>(4096, size() / (pool.size() * 8) + 1);
+        const size_t slices = (size() + slice - 1) / slice;
+        std::vector<std::vector<int>> partial(slices);
+        pool.parallel_for(0, slices, [&](size_t lo, size_t hi) {
+            for (size_t s = lo; s < hi; ++s) {
+                for (size_t row = s * slice; row < std::min(size(), (s + 1) * slice); ++row) {
+                    if (kernels.contains(courses_begin(row), course_count(row), course_id)) partial[s].push_back(ids[row]);
+                }
+            }
+        }, 1);
+
+        std::vector<int> result;
+        for (const std::vector<int>& ids_found : partial) result.insert(result.end(), ids_found.begin(), ids_found.end());
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // Report: students enrolled in both courses (sorted IDs)
+    std::vector<int> co_enrolled(int course_a, int course_b) const {
+        std::vector<int> first = roster(course_a), second = roster(course_b);
+        std::vector<int> result(std::min(first.size(), second.size()));
+        result.resize(simd_intersect_sorted(first.data(), first.size(), second.data(), second.size(), result.data()));
+        return result;
+    }
+
+    // IDs of students enrolled in more than 'limit' courses (reads only the offsets column)
+    std::vector<int> students_with_more_than(size_t limit) const {
+        std::vector<int> result;
+        for (size_t row = 0; row < size(); ++row) {
+            if (course_offsets[row + 1] - course_offsets[row] > limit) result.push_back(ids[row]);
+        }
+        return result;
+    }
+};
+
+// =====================================================================
+// Arena-backed Student Dataset
+// A bulk load creates two small heap blocks per student (name and course
+// list). StudentDataset keeps its students as Rows whose name and course
+// list come from a monotonic arena owned by the dataset: the loader
+// bump-allocates them, individual frees are no-ops and the whole arena is
+// released in one shot by reset() or the destructor. Only this type uses
+// polymorphic allocators; Student itself keeps std::string and std::vector.
+// Memory freed by later edits (e.g. a course list growing) is only
+// reclaimed on reset(), so this mode suits load-mostly workloads.
+// =====================================================================
+class StudentDataset {
+public:
+    // One student in the dataset: Student's fields, allocated from the arena
+    struct Row {
+        int id;
+        int roll;
+        std::pmr::string name;
+        std::pmr::vector<int> course_ids;
+
+        Row(int student_id, std::string_view student_name, int roll_number, std::pmr::memory_resource* resource)
+            : id(student_id), roll(roll_number), name(student_name, resource), course_ids(resource) {}
+
+        inline int get_id() const { return id; }
+    };
+
+private:
+    // Declared before 'rows' so the records are destroyed before the arena
+    std::pmr::monotonic_buffer_resource arena;
+    RecordList<Row> rows;
+
+public:
+    explicit StudentDataset(size_t initial_bytes = 64 * 1024) : arena(initial_bytes) {}
+
+    StudentDataset(const StudentDataset&) = delete;
+    StudentDataset& operator=(const StudentDataset&) = delete;
+
+    // Drops every record, then returns all arena memory at once
+    void reset() {
+        rows.clear();
+        arena.release();
+    }
+
+    inline RecordList<Row>& records() { return rows; }
+    inline const RecordList<Row>& records() const { return rows; }
+    inline std::pmr::memory_resource* resource() { return &arena; }
+};
+
+// =====================================================================
+// Zero-copy Record Parsing
+// Helpers that parse the pipe-delimited record format directly out of a
+// memory buffer using std::string_view and std::from_chars, so no
+// temporary strings or streams are created per field.
+// =====================================================================
+
+// Read-only memory map of a whole file (RAII: unmapped in the destructor)
+class MappedFile {
+private:
+    int fd = -1;
+    const char* data = nullptr;
+    size_t length = 0;
+
+public:
+    explicit MappedFile(const std::string& path) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return; // Missing file: is_open() reports false
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            fd = -1;
+            throw SystemException("Could not stat file: " + path);
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length == 0) return; // mmap() rejects empty mappings; an empty view is fine
+
+        void* addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            fd = -1;
+            throw SystemException("Could not memory-map file: " + path);
+        }
+        ::madvise(addr, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(addr);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data) ::munmap(const_cast<char*>(data), length);
+        if (fd >= 0) ::close(fd);
+    }
+
+    inline bool is_open() const { return fd >= 0; }
+    inline std::string_view view() const { return std::string_view(data, length); }
+
+    // For random access after a sequential pass (stops read-ahead of neighbouring pages)
+    void advise_random() const {
+        if (data) ::madvise(const_cast<char*>(data), length, MADV_RANDOM);
+    }
+};
+
+// A record's ID list as the parser found it: comma-separated text, or
+// packed int32 values from the binary encoding. Parsed on demand.
+struct IdList {
+    std::string_view data;
+    bool packed = false;
+};
+
+// One student line, pointing into the source buffer (id|name|roll|c1,c2,...)
+struct StudentRecordView {
+    int id = 0;
+    std::string_view name;
+    int roll = 0;
+    IdList course_ids;
+};
+
+// Pops the next line off 'data' (without the '\n' or a trailing '\r')
+inline std::string_view next_line(std::string_view& data) {
+    size_t end = data.find('\n');
+    std::string_view line = data.substr(0, end);
+    data.remove_prefix(end == std::string_view::npos ? data.size() : end + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+// Pops the next 'delimiter'-separated field off 'data'
+inline std::string_view next_field(std::string_view& data, char delimiter) {
+    size_t end = data.find(delimiter);
+    std::string_view field = data.substr(0, end);
+    data.remove_prefix(end == std::string_view::npos ? data.size() : end + 1);
+    return field;
+}
+
+inline bool parse_int(std::string_view text, int& value) {
+    const char* last = text.data() + text.size();
+    std::from_chars_result result = std::from_chars(text.data(), last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+// One course line, pointing into the source buffer (id|title|capacity|enrolled)
+struct CourseRecordView {
+    int id = 0;
+    std::string_view title;
+    int capacity = 0;
+    int enrolled = 0;
+};
+
+// One faculty line (id|name|department|c1,c2,...: the courses taught)
+struct FacultyRecordView {
+    int id = 0;
+    std::string_view name;
+    std::string_view department;
+    IdList course_ids;
+};
+
+// Calls fn(course_id) for each entry of a comma-separated ID list.
+// Returns nullptr on success, or a reason if an entry is not a number.
+template <typename Fn>
+const char* for_each_course_id(std::string_view list, Fn&& fn) {
+    while (!list.empty()) {
+        int course_id;
+        if (!parse_int(next_field(list, ','), course_id)) return "invalid course ID";
+        fn(course_id);
+    }
+    return nullptr;
+}
+
+template <typename Fn>
+const char* for_each_course_id(IdList list, Fn&& fn) {
+    if (!list.packed) return for_each_course_id(list.data, fn);
+    for (size_t at = 0; at + sizeof(int32_t) <= list.data.size(); at += sizeof(int32_t)) {
+        int32_t course_id;
+        std::memcpy(&course_id, list.data.data() + at, sizeof(course_id));
+        fn(static_cast<int>(course_id));
+    }
+    return nullptr;
+}
+
+// Splits a buffer into roughly equal pieces that all end on a newline
+inline std::vector<std::string_view> split_at_newlines(std::string_view data, unsigned parts) {
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    for (unsigned i = 1; i <= parts && begin < data.size(); ++i) {
+        size_t end = data.size() * i / parts;
+        if (end < begin) end = begin;
+        if (i < parts) {
+            size_t newline = data.find('\n', end);
+            end = (newline == std::string_view::npos) ? data.size() : newline + 1;
+        } else {
+            end = data.size();
+        }
+        chunks.push_back(data.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+// Timings reported by the parallel loaders
+struct LoadTimings {
+    double map_ms = 0;
+    double parse_ms = 0;
+    double merge_ms = 0;
+    unsigned threads = 1;
+    size_t records = 0;
+    size_t skipped = 0;
+};
+
+// =====================================================================
+// Record Schemas
+// Each record type describes its fields once, at compile time, in file
+// order: how to read the value from a record and where a parser stores
+// it in the matching *RecordView. RecordCodec generates every format
+// from that one list:
+//  - write_text(): the pipe-delimited line, written with std::to_chars
+//    straight into a caller-supplied buffer (no allocation per field);
+//  - parse_text(): the matching std::from_chars-based parser;
+//  - write_binary() / parse_binary(): a length-prefixed binary encoding
+//    (int32 values, u32 length + bytes for text, u32 count + int32s for lists).
+// Adding a field to a schema updates the text and binary formats together.
+// =====================================================================
+
+// One field of a schema. 'get' reads the value from a record; it is a
+// generic lambda, so any type with the same getters (e.g. a StudentTable
+// row) can be written too. The type of 'slot' picks the encoding: int,
+// text (std::string_view) or an ID list (IdList).
+template <typename View, typename Member, typename Get>
+struct SchemaField {
+    using member_type = Member;
+    Get get;
+    Member View::* slot;
+    const char* invalid; // Parse error for a malformed value (int fields)
+};
+
+template <typename View, typename Member, typename Get>
+constexpr SchemaField<View, Member, Get> schema_field(Member View::* slot, Get get, const char* invalid = nullptr) {
+    return SchemaField<View, Member, Get>{get, slot, invalid};
+}
+
+template <typename Record> struct RecordSchema; // Specialized for each record type below
+
+template <> struct RecordSchema<Student> {
+    using View = StudentRecordView;
+    static constexpr auto fields = std::make_tuple(
+        schema_field(&View::id, [](const auto& s) { return s.get_id(); }, "invalid student ID"),
+        schema_field(&View::name, [](const auto& s) { return s.get_name(); }),
+        schema_field(&View::roll, [](const auto& s) { return s.get_roll_number(); }, "invalid roll number"),
+        schema_field(&View::course_ids, [](const auto& s) -> decltype(auto) { return s.get_enrolled_course_ids(); },
+                     "invalid course ID"));
+};
+
+template <> struct RecordSchema<Course> {
+    using View = CourseRecordView;
+    static constexpr auto fields = std::make_tuple(
+        schema_field(&View::id, [](const auto& c) { return c.get_id(); }, "invalid course ID"),
+        schema_field(&View::title, [](const auto& c) -> decltype(auto) { return c.get_title(); }),
+        schema_field(&View::capacity, [](const auto& c) { return c.get_capacity(); }, "invalid capacity"),
+        schema_field(&View::enrolled, [](const auto& c) { return c.get_enrolled_students(); }, "invalid enrollment count"));
+};
+
+template <> struct RecordSchema<Faculty> {
+    using View = FacultyRecordView;
+    static constexpr auto fields = std::make_tuple(
+        schema_field(&View::id, [](const auto& f) { return f.get_id(); }, "invalid faculty ID"),
+        schema_field(&View::name, [](const auto& f) { return f.get_name(); }),
+        schema_field(&View::department, [](const auto& f) -> decltype(auto) { return f.get_department(); }),
+        schema_field(&View::course_ids, [](const auto& f) -> decltype(auto) { return f.get_courses_taught(); },
+                     "invalid course ID"));
+};
+
+template <typename Record>
+class RecordCodec {
+public:
+    using View = typename RecordSchema<Record>::View;
+
+private:
+    static const char FIELD_SEPARATOR = '|';
+    static const char LIST_SEPARATOR = ',';
+    static const size_t MAX_INT_CHARS = 11; // "-2147483648"
+
+    // Calls fn(field) for each field in order, stopping at the first false
+    template <typename Fn>
+    static bool all_fields(Fn&& fn) {
+        return std::apply([&](const auto&... field) { return (fn(field) && ...); }, RecordSchema<Record>::fields);
+    }
+
+    template <typename Field>
+    using member_of = typename std::decay_t<Field>::member_type;
+
+    // ID list entries are IDs or records that have one (Faculty lists Course*)
+    static int id_of(int id) { return id; }
+    template <typename T>
+    static int id_of(const T* record) { return record->get_id(); }
+
+    // Text writers: each returns the new end, or nullptr once the buffer is too small
+    static char* put_int(char* first, char* last, int value) {
+        if (!first) return nullptr;
+        std::to_chars_result result = std::to_chars(first, last, value);
+        return result.ec == std::errc() ? result.ptr : nullptr;
+    }
+
+    static char* put_text(char* first, char* last, std::string_view text) {
+        if (!first || static_cast<size_t>(last - first) < text.size()) return nullptr;
+        std::memcpy(first, text.data(), text.size());
+        return first + text.size();
+    }
+
+    static char* put_char(char* first, char* last, char c) {
+        if (!first || first == last) return nullptr;
+        *first = c;
+        return first + 1;
+    }
+
+    template <typename Member, typename Value>
+    static char* put_value(char* first, char* last, const Value& value) {
+        if constexpr (std::is_same<Member, int>::value) {
+            return put_int(first, last, value);
+        } else if constexpr (std::is_same<Member, std::string_view>::value) {
+            return put_text(first, last, value);
+        } else {
+            bool separator = false;
+            for (const auto& item : value) {
+                if (separator) first = put_char(first, last, LIST_SEPARATOR);
+                first = put_int(first, last, id_of(item));
+                separator = true;
+            }
+            return first;
+        }
+    }
+
+    template <typename Member, typename Value>
+    static size_t max_value_size(const Value& value) {
+        if constexpr (std::is_same<Member, int>::value) {
+            return MAX_INT_CHARS;
+        } else if constexpr (std::is_same<Member, std::string_view>::value) {
+            return std::string_view(value).size();
+        } else {
+            return value.size() * (MAX_INT_CHARS + 1);
+        }
+    }
+
+    // Binary writers: same contract as the text writers
+    static char* put_u32(char* first, char* last, uint32_t value) {
+        if (!first || static_cast<size_t>(last - first) < sizeof(value)) return nullptr;
+        std::memcpy(first, &value, sizeof(value));
+        return first + sizeof(value);
+    }
+
+    template <typename Member, typename Value>
+    static char* put_binary(char* first, char* last, const Value& value) {
+        if constexpr (std::is_same<Member, int>::value) {
+            return put_u32(first, last, static_cast<uint32_t>(value));
+        } else if constexpr (std::is_same<Member, std::string_view>::value) {
+            std::string_view text(value);
+            return put_text(put_u32(first, last, static_cast<uint32_t>(text.size())), last, text);
+        } else {
+            first = put_u32(first, last, static_cast<uint32_t>(value.size()));
+            for (const auto& item : value) first = put_u32(first, last, static_cast<uint32_t>(id_of(item)));
+            return first;
+        }
+    }
+
+    template <typename Member, typename Value>
+    static size_t binary_value_size(const Value& value) {
+        if constexpr (std::is_same<Member, int>::value) {
+            return sizeof(uint32_t);
+        } else if constexpr (std::is_same<Member, std::string_view>::value) {
+            return sizeof(uint32_t) + std::string_view(value).size();
+        } else {
+            return sizeof(uint32_t) * (1 + value.size());
+        }
+    }
+
+    static bool take_u32(std::string_view& data, uint32_t& value) {
+        if (data.size() < sizeof(value)) return false;
+        std::memcpy(&value, data.data(), sizeof(value));
+        data.remove_prefix(sizeof(value));
+        return true;
+    }
+
+    static bool take_bytes(std::string_view& data, size_t length, std::string_view& bytes) {
+        if (data.size() < length) return false;
+        bytes = data.substr(0, length);
+        data.remove_prefix(length);
+        return true;
+    }
+
+public:
+    // Upper bound on the length of write_text()'s output (without a newline)
+    template <typename Source>
+    static size_t max_text_size(const Source& record) {
+        size_t size = 0;
+        all_fields([&](const auto& field) {
+            size += max_value_size<member_of<decltype(field)>>(field.get(record)) + 1;
+            return true;
+        });
+        return size;
+    }
+
+    // Writes one line (without the newline) into [first, last).
+    // Returns the end of the line, or nullptr if the buffer is too small.
+    template <typename Source>
+    static char* write_text(const Source& record, char* first, char* last) {
+        bool separator = false;
+        all_fields([&](const auto& field) {
+            if (separator) first = put_char(first, last, FIELD_SEPARATOR);
+            first = put_value<member_of<decltype(field)>>(first, last, field.get(record));
+            separator = true;
+            return first != nullptr;
+        });
+        return first;
+    }
+
+    // Appends one line (without the newline); the string's capacity is reused across calls
+    template <typename Source>
+    static void append_text(std::string& out, const Source& record) {
+        size_t at = out.size();
+        out.resize(at + max_text_size(record));
+        char* end = write_text(record, &out[at], &out[0] + out.size());
+        out.resize(static_cast<size_t>(end - out.data()));
+    }
+
+    template <typename Source>
+    static std::string to_text(const Source& record) {
+        std::string line;
+        append_text(line, record);
+        return line;
+    }
+
+    // Parses one line into 'out' (text fields point into 'line'; ID lists are
+    // checked when iterated). Returns nullptr on success, or a short reason
+    // why the line is corrupt. A trailing ID list may be left out entirely.
+    static const char* parse_text(std::string_view line, View& out) {
+        std::string_view rest = line;
+        bool more = true; // A separator followed the previous field
+        const char* error = nullptr;
+        all_fields([&](const auto& field) {
+            using Member = member_of<decltype(field)>;
+            if (!more) {
+                if constexpr (std::is_same<Member, IdList>::value) {
+                    out.*field.slot = IdList{};
+                    return true;
+                }
+                error = "missing fields";
+                return false;
+            }
+            more = rest.find(FIELD_SEPARATOR) != std::string_view::npos;
+            std::string_view text = next_field(rest, FIELD_SEPARATOR);
+            if constexpr (std::is_same<Member, int>::value) {
+                if (!parse_int(text, out.*field.slot)) {
+                    error = field.invalid;
+                    return false;
+                }
+            } else if constexpr (std::is_same<Member, std::string_view>::value) {
+                out.*field.slot = text;
+            } else {
+                out.*field.slot = IdList{text, false};
+            }
+            return true;
+        });
+        return error;
+    }
+
+    // Exact size of write_binary()'s output
+    template <typename Source>
+    static size_t binary_size(const Source& record) {
+        size_t size = 0;
+        all_fields([&](const auto& field) {
+            size += binary_value_size<member_of<decltype(field)>>(field.get(record));
+            return true;
+        });
+        return size;
+    }
+
+    // Writes one binary record into [first, last). Returns its end, or nullptr if the buffer is too small.
+    template <typename Source>
+    static char* write_binary(const Source& record, char* first, char* last) {
+        all_fields([&](const auto& field) {
+            first = put_binary<member_of<decltype(field)>>(first, last, field.get(record));
+            return first != nullptr;
+        });
+        return first;
+    }
+
+    template <typename Source>
+    static void append_binary(std::string& out, const Source& record) {
+        size_t at = out.size();
+        out.resize(at + binary_size(record));
+        write_binary(record, &out[at], &out[0] + out.size());
+    }
+
+    // Parses the binary record at the front of 'data' and removes it.
+    // Returns nullptr on success, or a reason if the record is cut short.
+    static const char* parse_binary(std::string_view& data, View& out) {
+        bool ok = all_fields([&](const auto& field) {
+            using Member = member_of<decltype(field)>;
+            uint32_t value;
+            if (!take_u32(data, value)) return false;
+            if constexpr (std::is_same<Member, int>::value) {
+                out.*field.slot = static_cast<int>(value);
+                return true;
+            } else if constexpr (std::is_same<Member, std::string_view>::value) {
+                return take_bytes(data, value, out.*field.slot);
+            } else {
+                std::string_view packed;
+                if (static_cast<size_t>(value) > data.size() / sizeof(int32_t)) return false;
+                take_bytes(data, value * sizeof(int32_t), packed);
+                out.*field.slot = IdList{packed, true};
+                return true;
+            }
+        });
+        return ok ? nullptr : "truncated record";
+    }
+};
+
+// Line parsers used by the loaders
+inline const char* parse_student_line(std::string_view line, StudentRecordView& out) {
+    return RecordCodec<Student>::parse_text(line, out);
+}
+
+inline const char* parse_course_line(std::string_view line, CourseRecordView& out) {
+    return RecordCodec<Course>::parse_text(line, out);
+}
+
+// File Handling helpers for saving (declared in the record classes)
+inline std::string Course::to_string() const { return RecordCodec<Course>::to_text(*this); }
+inline std::string Student::to_string() const { return RecordCodec<Student>::to_text(*this); }
+inline std::string Faculty::to_string() const { return RecordCodec<Faculty>::to_text(*this); }
+inline void Student::append_record(std::string& out) const { RecordCodec<Student>::append_text(out, *this); }
+inline void Faculty::append_record(std::string& out) const { RecordCodec<Faculty>::append_text(out, *this); }
+
+// =====================================================================
+// Type-Partitioned User Store
+// A std::vector<User*> keeps every user behind a pointer, each one a
+// separate heap object, and every call goes through the vtable.
+// UserStore keeps Students and Faculty in two contiguous arrays instead
+// and hands the visitor the concrete type, so calls are bound at compile
+// time (Student and Faculty are final) and can be inlined:
+//  - visit(fn) calls fn(Student&) for every student, then fn(Faculty&)
+//    for every faculty member (a generic lambda or an Overloaded set);
+//  - find(id) returns a UserRef (std::variant<Student*, Faculty*>) for
+//    std::visit;
+//  - users() adapts the store to code written against User*.
+// Adding users may move the arrays: references, UserRefs and users()
+// pointers are valid until the next add.
+// =====================================================================
+template <typename... Fns>
+struct Overloaded : Fns... {
+    using Fns::operator()...;
+};
+template <typename... Fns>
+Overloaded(Fns...) -> Overloaded<Fns...>;
+
+using UserRef = std::variant<Student*, Faculty*>;
+
+class UserStore {
+private:
+    struct Slot {
+        bool is_faculty;
+        uint32_t index;
+    };
+
+    std::vector<Student> students;
+    std::vector<Faculty> faculty;
+    std::unordered_map<int, Slot> by_id; // User ID -> array and position
+
+    void claim_id(int id, Slot slot) {
+        if (!by_id.emplace(id, slot).second) {
+            throw SystemException("User ID " + std::to_string(id) + " is already in the store.");
+        }
+    }
+
+public:
+    Student& add(Student student) {
+        claim_id(student.get_id(), Slot{false, static_cast<uint32_t>(students.size())});
+        students.push_back(std::move(student));
+        return students.back();
+    }
+
+    Faculty& add(Faculty member) {
+        claim_id(member.get_id(), Slot{true, static_cast<uint32_t>(faculty.size())});
+        faculty.push_back(std::move(member));
+        return faculty.back();
+    }
+
+    void reserve(size_t student_count, size_t faculty_count) {
+        students.reserve(student_count);
+        faculty.reserve(faculty_count);
+        by_id.reserve(student_count + faculty_count);
+    }
+
+    inline size_t size() const { return students.size() + faculty.size(); }
+    inline std::vector<Student>& get_students() { return students; }
+    inline std::vector<Faculty>& get_faculty() { return faculty; }
+
+    std::optional<UserRef> find(int id) {
+        auto it = by_id.find(id);
+        if (it == by_id.end()) return std::nullopt;
+        if (it->second.is_faculty) return UserRef(&faculty[it->second.index]);
+        return UserRef(&students[it->second.index]);
+    }
+
+    template <typename Visitor>
+    void visit(Visitor&& fn) {
+        for (Student& s : students) fn(s);
+        for (Faculty& f : faculty) fn(f);
+    }
+
+    template <typename Visitor>
+    void visit(Visitor&& fn) const {
+        for (const Student& s : students) fn(s);
+        for (const Faculty& f : faculty) fn(f);
+    }
+
+    template <typename Predicate>
+    size_t count_if(Predicate&& pred) const {
+        size_t count = 0;
+        visit([&](const auto& user) { count += pred(user) ? 1 : 0; });
+        return count;
+    }
+
+    // IDs of the matching users (students first, then faculty)
+    template <typename Predicate>
+    std::vector<int> filter_ids(Predicate&& pred) const {
+        std::vector<int> ids;
+        visit([&](const auto& user) {
+            if (pred(user)) ids.push_back(user.get_id());
+        });
+        return ids;
+    }
+
+    // Every user's record line (from its RecordSchema), one per line
+    void export_text(std::string& out) const {
+        visit([&](const auto& user) {
+            user.append_record(out);
+            out += '\n';
+        });
+    }
+
+    // Adapter for code written against the User interface
+    std::vector<User*> users() {
+        std::vector<User*> result;
+        result.reserve(size());
+        visit([&](User& user) { result.push_back(&user); });
+        return result;
+    }
+};
+
+// =====================================================================
+// Streaming Record Queries
+// Answers ad-hoc questions ("which students are in course 201?") straight
+// from student_records.txt without building a RecordList<Student>:
+//  - LineReader reads the file through one fixed-size buffer, so memory
+//    stays constant however large the file is;
+//  - StudentQuery splits each line into raw fields and only parses the
+//    fields the projection (select) and the filters (where) ask for;
+//  - in_course() checks course membership on the raw ID list, stopping
+//    at the first match, without building a vector.
+// A query is single-pass: create a new one to read the file again.
+// Fields that are never parsed are not validated either, so a line is
+// reported as corrupt only if one of the requested fields is bad.
+// =====================================================================
+
+// Reads a file line by line through a reusable buffer (RAII: closes the file)
+class LineReader {
+private:
+    int fd = -1;
+    std::unique_ptr<char[]> buffer;
+    size_t capacity = 0;
+    size_t begin = 0, end = 0; // Unconsumed bytes are buffer[begin, end)
+    bool eof = false;
+    size_t line_number = 0;
+
+    // Moves the unconsumed tail to the front and reads more; grows the buffer only for a line longer than it
+    bool fill() {
+        if (eof) return false;
+        if (begin > 0) {
+            std::memmove(buffer.get(), buffer.get() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if (end == capacity) {
+            std::unique_ptr<char[]> bigger(new char[capacity * 2]);
+            std::memcpy(bigger.get(), buffer.get(), end);
+            buffer = std::move(bigger);
+            capacity *= 2;
+        }
+        ssize_t got;
+        do {
+            got = ::read(fd, buffer.get() + end, capacity - end);
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) throw SystemException("Could not read record file.");
+        if (got == 0) eof = true;
+        end += static_cast<size_t>(got);
+        return got > 0;
+    }
+
+public:
+    explicit LineReader(const std::string& path, size_t buffer_size = 1 << 20)
+        : buffer(new char[std::max<size_t>(buffer_size, 64)]), capacity(std::max<size_t>(buffer_size, 64)) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd >= 0) ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    LineReader(LineReader&& other) noexcept
+        : fd(other.fd), buffer(std::move(other.buffer)), capacity(other.capacity), begin(other.begin),
+          end(other.end), eof(other.eof), line_number(other.line_number) {
+        other.fd = -1;
+    }
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+    LineReader& operator=(LineReader&&) = delete;
+
+    ~LineReader() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    inline bool is_open() const { return fd >= 0; }
+    inline size_t current_line() const { return line_number; }
+
+    // The view stays valid until the next call
+    bool next(std::string_view& line) {
+        if (fd < 0) return false;
+        while (true) {
+            const char* start = buffer.get() + begin;
+            const char* newline = static_cast<const char*>(std::memchr(start, '\n', end - begin));
+            if (newline) {
+                line = std::string_view(start, static_cast<size_t>(newline - start));
+                begin += line.size() + 1;
+                break;
+            }
+            if (!fill()) {
+                if (begin == end) return false;
+                line = std::string_view(buffer.get() + begin, end - begin); // Last line without '\n'
+                begin = end;
+                break;
+            }
+        }
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        line_number++;
+        return true;
+    }
+};
+
+// Fields a query can ask for (combine with |)
+enum StudentField : unsigned {
+    FIELD_ID = 1,
+    FIELD_NAME = 2,
+    FIELD_ROLL = 4,
+    FIELD_COURSES = 8,
+    FIELD_ALL = 15
+};
+
+// One matching record. Only the selected fields are filled in; 'name' and
+// 'course_ids' point into the reader's buffers and are valid until the next row.
+struct StudentQueryRow {
+    int id = 0;
+    std::string_view name;
+    int roll = 0;
+    const int* course_ids = nullptr;
+    size_t course_count = 0;
+    size_t line = 0; // Line number in the file
+
+    inline const int* courses_begin() const { return course_ids; }
+    inline const int* courses_end() const { return course_ids + course_count; }
+};
+
+class StudentQuery {
+public:
+    struct Stats {
+        size_t lines = 0;
+        size_t matched = 0;
+        size_t corrupt = 0;
+    };
+
+private:
+    struct Filter {
+        unsigned fields; // What the predicate reads
+        std::function<bool(const StudentQueryRow&)> predicate;
+    };
+
+    LineReader reader;
+    unsigned projection = FIELD_ALL;
+    std::vector<int> course_filter; // in_course(): all of these must be present
+    std::vector<Filter> filters;
+    std::vector<int> course_scratch; // Reused for every row
+    Stats counters;
+
+    // True if 'course_id' is in the raw comma-separated list (no allocation, stops at the first hit)
+    static bool raw_list_contains(std::string_view list, int course_id, const char*& error) {
+        while (!list.empty()) {
+            int value;
+            if (!parse_int(next_field(list, ','), value)) {
+                error = "invalid course ID";
+                return false;
+            }
+            if (value == course_id) return true;
+        }
+        return false;
+    }
+
+    // Parses the fields in 'wanted' that are not in 'parsed' yet; returns an error reason or nullptr
+    const char* parse_fields(unsigned wanted, unsigned& parsed, std::string_view id_field, std::string_view name_field,
+                             std::string_view roll_field, std::string_view course_field, StudentQueryRow& row) {
+        unsigned missing = wanted & ~parsed;
+        if ((missing & FIELD_ID) && !parse_int(id_field, row.id)) return "invalid student ID";
+        if (missing & FIELD_NAME) row.name = name_field;
+        if ((missing & FIELD_ROLL) && !parse_int(roll_field, row.roll)) return "invalid roll number";
+        if (missing & FIELD_COURSES) {
+            course_scratch.clear();
+            const char* error = for_each_course_id(course_field, [&](int course_id) {
+                // Same duplicate check as the loaders
+                if (std::find(course_scratch.begin(), course_scratch.end(), course_id) == course_scratch.end()) {
+                    course_scratch.push_back(course_id);
+                }
+            });
+            if (error) return error;
+            row.course_ids = course_scratch.data();
+            row.course_count = course_scratch.size();
+        }
+        parsed |= missing;
+        return nullptr;
+    }
+
+public:
+    explicit StudentQuery(const std::string& path, size_t buffer_size = 1 << 20) : reader(path, buffer_size) {}
+
+    // Projection: which fields matching rows carry (default: all)
+    StudentQuery& select(unsigned fields) {
+        projection = fields;
+        return *this;
+    }
+
+    // Filter: keep rows for which 'predicate' is true. 'fields' lists what the predicate reads.
+    StudentQuery& where(unsigned fields, std::function<bool(const StudentQueryRow&)> predicate) {
+        filters.push_back(Filter{fields, std::move(predicate)});
+        return *this;
+    }
+
+    // Filter: keep students enrolled in 'course_id' (checked before any other field is parsed)
+    StudentQuery& in_course(int course_id) {
+        course_filter.push_back(course_id);
+        return *this;
+    }
+
+    inline bool is_open() const { return reader.is_open(); }
+    inline const Stats& stats() const { return counters; }
+
+    // Advances to the next matching row; false at the end of the file
+    bool next(StudentQueryRow& row) {
+        std::string_view line;
+        while (reader.next(line)) {
+            counters.lines++;
+            if (line.empty()) continue;
+
+            std::string_view rest = line;
+            std::string_view id_field = next_field(rest, '|');
+            const char* error = nullptr;
+            if (rest.empty()) error = "missing fields";
+            std::string_view name_field = next_field(rest, '|');
+            if (!error && rest.empty()) error = "missing fields";
+            std::string_view roll_field = next_field(rest, '|');
+            std::string_view course_field = next_field(rest, '|');
+
+            bool keep = !error;
+            for (size_t i = 0; keep && i < course_filter.size(); ++i) {
+                keep = raw_list_contains(course_field, course_filter[i], error);
+            }
+
+            row = StudentQueryRow();
+            row.line = reader.current_line();
+            unsigned parsed = 0;
+            for (size_t i = 0; keep && i < filters.size(); ++i) {
+                error = parse_fields(filters[i].fields, parsed, id_field, name_field, roll_field, course_field, row);
+                keep = !error && filters[i].predicate(row);
+            }
+            if (keep) error = parse_fields(projection, parsed, id_field, name_field, roll_field, course_field, row);
+
+            if (error) {
+                counters.corrupt++;
+                UMS_COUNT(Counter::CorruptLines, 1);
+                UMS_LOG(LogLevel::Error) << "[QUERY ERROR] Corrupt data line " << row.line << " skipped: " << line << " ("
+                                         << error << ")";
+                continue;
+            }
+            if (!keep) continue;
+            counters.matched++;
+            return true;
+        }
+        return false;
+    }
+
+    // Calls fn(const StudentQueryRow&) for every matching row; returns the number of matches
+    template <typename Fn>
+    size_t for_each(Fn&& fn) {
+        UMS_TRACE_SPAN("query.students");
+        StudentQueryRow row;
+        size_t matches = 0;
+        while (next(row)) {
+            fn(row);
+            matches++;
+        }
+        return matches;
+    }
+
+    // Counts the matching rows (parses only what the filters need)
+    size_t count() {
+        projection = 0;
+        return for_each([](const StudentQueryRow&) {});
+    }
+};
+
+// =====================================================================
+// Binary Snapshot Format
+// A versioned, fixed-width image of the whole database that can be used
+// straight out of a single mmap:
+//
+//   SnapshotHeader | SnapshotStudent[] | SnapshotCourse[] | int32 course IDs[] | string pool
+//
+// Names and titles live in the string pool, and each student's enrolled
+// courses are a slice (offset + count) of the flat course-ID array.
+// Integers are stored in native byte order; byte_order detects a mismatch.
+// =====================================================================
+const char SNAPSHOT_MAGIC[8] = {'U', 'M', 'S', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 2; // v2 added journal_lsn
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t student_count;
+    uint64_t course_count;
+    uint64_t course_id_count;
+    uint64_t string_pool_size;
+    int32_t next_roll_number;
+    uint32_t reserved;
+    uint64_t journal_lsn; // v2: last journal record folded into this snapshot (0 in v1 files)
+};
+
+struct SnapshotStudent {
+    int32_t id;
+    int32_t roll;
+    uint64_t name_offset; // Into the string pool
+    uint32_t name_length;
+    uint32_t course_count;
+    uint64_t first_course; // Index into the course-ID array
+};
+
+struct SnapshotCourse {
+    int32_t id;
+    int32_t capacity;
+    int32_t enrolled;
+    uint32_t title_length;
+    uint64_t title_offset; // Into the string pool
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must stay fixed-width");
+static_assert(sizeof(SnapshotStudent) == 32, "snapshot student record must stay fixed-width");
+static_assert(sizeof(SnapshotCourse) == 24, "snapshot course record must stay fixed-width");
+
+// =====================================================================
+// Write-Ahead Journal
+// Append-only log of mutations. Each record is
+//
+//   u32 payload size | u8 op | u64 LSN | payload | u32 checksum
+//
+// Appends only copy into a memory buffer; a background thread writes the
+// buffer and fsyncs it in batches (group commit), either every few
+// milliseconds or as soon as enough bytes are pending.
+// =====================================================================
+enum class JournalOp : uint8_t {
+    AddStudent = 1,       // id, roll, name, course IDs
+    Enroll = 2,           // student ID, course ID, seat taken (0/1; absent in older journals)
+    CourseEnrollment = 3, // course ID (Course::increment_enrollment)
+    Unenroll = 4          // student ID, course ID, seat released (0/1)
+};
+
+// Loops until the whole buffer is written (write() may be partial)
+inline bool write_fully(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Creates an empty temporary file next to 'path' with a unique name
+// ("<path>.tmp.XXXXXX", mkstemp), so two saves of the same file never write
+// into each other's temporary file. Returns the descriptor, or -1.
+inline int create_temp_file(const std::string& path, std::string& tmp_path) {
+    std::string pattern = path + ".tmp.XXXXXX";
+    int fd = ::mkstemp(&pattern[0]);
+    if (fd < 0) return -1;
+    ::fchmod(fd, 0644); // mkstemp creates the file 0600
+    tmp_path = pattern;
+    return fd;
+}
+
+// Opens a new temporary file for 'path' (see create_temp_file) as 'out' and
+// returns its name; if 'out' does not open, the file is already removed
+inline std::string open_temp_stream(const std::string& path, std::ofstream& out,
+                                    std::ios::openmode mode = std::ios::out) {
+    std::string tmp_path;
+    int fd = create_temp_file(path, tmp_path);
+    if (fd < 0) return std::string();
+    ::close(fd);
+    out.open(tmp_path, mode | std::ios::trunc);
+    if (!out.is_open()) std::remove(tmp_path.c_str());
+    return tmp_path;
+}
+
+// fsyncs a temporary file written through a stream, then renames it over
+// 'path'. If it was not fully written, or either step fails, the temporary
+// file is removed and false is returned.
+inline bool commit_temp_file(const std::string& tmp_path, const std::string& path, bool written) {
+    if (written) {
+        int fd = ::open(tmp_path.c_str(), O_RDONLY);
+        written = fd >= 0 && ::fsync(fd) == 0;
+        if (fd >= 0) written = (::close(fd) == 0) && written;
+    }
+    if (!written || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// FNV-1a, enough to detect a torn or garbled record at the end of the journal
+inline uint32_t journal_checksum(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+// Builds a journal payload
+class JournalWriter {
+private:
+    std::string buffer;
+
+public:
+    void write_u32(uint32_t value) { buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+    void write_int(int value) { write_u32(static_cast<uint32_t>(value)); }
+    void write_string(std::string_view value) {
+        write_u32(static_cast<uint32_t>(value.size()));
+        buffer.append(value);
+    }
+    void write_bytes(std::string_view encoded) { buffer.append(encoded); } // Fields encoded by another writer
+    inline const std::string& bytes() const { return buffer; }
+};
+
+// Reads a journal payload back (fields in the order they were written)
+class JournalReader {
+private:
+    std::string_view data;
+
+public:
+    explicit JournalReader(std::string_view payload) : data(payload) {}
+
+    uint32_t read_u32() {
+        uint32_t value = 0;
+        if (data.size() < sizeof(value)) throw SystemException("Journal record is truncated.");
+        std::memcpy(&value, data.data(), sizeof(value));
+        data.remove_prefix(sizeof(value));
+        return value;
+    }
+    int read_int() { return static_cast<int>(read_u32()); }
+    bool at_end() const { return data.empty(); }
+    std::string_view read_string() {
+        uint32_t size = read_u32();
+        if (data.size() < size) throw SystemException("Journal record is truncated.");
+        std::string_view value = data.substr(0, size);
+        data.remove_prefix(size);
+        return value;
+    }
+};
+
+class Journal {
+private:
+    static constexpr size_t RECORD_OVERHEAD = 4 + 1 + 8 + 4;
+
+    std::string path;
+    int fd = -1;
+
+    std::mutex mutex; // Guards everything below
+    std::condition_variable wake_flusher;
+    std::condition_variable became_durable;
+    std::string pending; // Encoded records not yet handed to the flusher
+    std::string writing; // Batch currently being written (reused to avoid reallocations)
+    uint64_t next_lsn;
+    uint64_t durable_lsn;
+    bool flush_requested = false;
+    bool stopping = false;
+    bool failed = false;
+
+    std::mutex io_mutex; // Serializes batch writes with discard_through()
+    size_t group_commit_bytes;
+    std::chrono::milliseconds group_commit_interval;
+    std::thread flusher;
+
+    void flusher_loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake_flusher.wait_for(lock, group_commit_interval, [this] {
+                return stopping || flush_requested || pending.size() >= group_commit_bytes;
+            });
+            flush_requested = false;
+            if (pending.empty()) {
+                if (stopping) break;
+                continue;
+            }
+            writing.clear();
+            writing.swap(pending);
+            uint64_t batch_lsn = next_lsn - 1;
+            lock.unlock();
+
+            bool ok;
+            {
+                std::lock_guard<std::mutex> io(io_mutex);
+                ok = write_fully(fd, writing.data(), writing.size()) && ::fdatasync(fd) == 0;
+            }
+
+            lock.lock();
+            if (ok) {
+                durable_lsn = batch_lsn;
+            } else {
+                failed = true;
+            }
+            became_durable.notify_all();
+        }
+    }
+
+public:
+    Journal(const std::string& file_path, uint64_t first_lsn, size_t batch_bytes = 64 * 1024,
+            std::chrono::milliseconds batch_interval = std::chrono::milliseconds(5))
+        : path(file_path), next_lsn(first_lsn), durable_lsn(first_lsn - 1),
+          group_commit_bytes(batch_bytes), group_commit_interval(batch_interval) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            throw SystemException("Could not open journal file: " + path);
+        }
+        flusher = std::thread(&Journal::flusher_loop, this);
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Flushes whatever is still pending before closing
+    ~Journal() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake_flusher.notify_one();
+        flusher.join();
+        ::close(fd);
+    }
+
+    // Appends one record and returns its LSN. Does not wait for the disk.
+    uint64_t append(JournalOp op, const std::string& payload) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t lsn = next_lsn++;
+        uint32_t size = static_cast<uint32_t>(payload.size());
+        size_t start = pending.size();
+        pending.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        pending.push_back(static_cast<char>(op));
+        pending.append(reinterpret_cast<const char*>(&lsn), sizeof(lsn));
+        pending.append(payload);
+        uint32_t checksum = journal_checksum(pending.data() + start, pending.size() - start);
+        pending.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        if (pending.size() >= group_commit_bytes) {
+            wake_flusher.notify_one();
+        }
+        return lsn;
+    }
+
+    // Blocks until the record with the given LSN has been fsynced
+    void wait_durable(uint64_t lsn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (durable_lsn >= lsn) return;
+        flush_requested = true;
+        wake_flusher.notify_one();
+        became_durable.wait(lock, [&] { return durable_lsn >= lsn || failed; });
+        if (failed) {
+            throw SystemException("Could not write to journal file: " + path);
+        }
+    }
+
+    uint64_t last_lsn() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return next_lsn - 1;
+    }
+
+    // Drops records with LSN <= 'lsn' (already folded into a snapshot) by
+    // rewriting the remaining tail into a new file and renaming it into place
+    void discard_through(uint64_t lsn) {
+        wait_durable(lsn);
+        std::lock_guard<std::mutex> io(io_mutex);
+
+        std::string tail;
+        replay(path, lsn, [&](JournalOp, std::string_view) {}, &tail);
+        std::string tmp_path;
+        int new_fd = create_temp_file(path, tmp_path);
+        if (new_fd < 0 || ::fcntl(new_fd, F_SETFL, O_APPEND) != 0 || !write_fully(new_fd, tail.data(), tail.size()) ||
+            ::fsync(new_fd) != 0 || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            if (new_fd >= 0) {
+                ::close(new_fd);
+                std::remove(tmp_path.c_str());
+            }
+            throw SystemException("Could not compact journal file: " + path);
+        }
+        ::close(fd);
+        fd = new_fd;
+    }
+
+    // Calls fn(op, payload) for every intact record with LSN > after_lsn and
+    // returns the highest LSN seen. Stops at the first torn or corrupt record.
+    // If 'kept' is given, the raw bytes of the replayed records are appended to it.
+    template <typename Fn>
+    static uint64_t replay(const std::string& file_path, uint64_t after_lsn, Fn&& fn, std::string* kept = nullptr) {
+        MappedFile file(file_path);
+        if (!file.is_open()) return 0;
+        return replay_buffer(file.view(), after_lsn, fn, kept);
+    }
+
+    // Cuts off a torn or corrupt tail so new appends land after the last good record.
+    // Returns the number of bytes removed.
+    static size_t truncate_torn_tail(const std::string& file_path) {
+        MappedFile file(file_path);
+        if (!file.is_open()) return 0;
+        std::string_view data = file.view();
+        size_t intact = 0;
+        replay_buffer(data, 0, [](JournalOp, std::string_view) {}, nullptr, &intact);
+        if (intact < data.size() && ::truncate(file_path.c_str(), static_cast<off_t>(intact)) != 0) {
+            throw SystemException("Could not truncate journal file: " + file_path);
+        }
+        return data.size() - intact;
+    }
+
+private:
+    template <typename Fn>
+    static uint64_t replay_buffer(std::string_view data, uint64_t after_lsn, Fn&& fn, std::string* kept,
+                                  size_t* intact_bytes = nullptr) {
+        size_t total = data.size();
+        uint64_t last_lsn = 0;
+        while (data.size() >= RECORD_OVERHEAD) {
+            uint32_t size;
+            uint64_t lsn;
+            uint32_t checksum;
+            std::memcpy(&size, data.data(), sizeof(size));
+            if (data.size() < RECORD_OVERHEAD + size) break; // Torn write at the tail
+            std::memcpy(&lsn, data.data() + 5, sizeof(lsn));
+            std::memcpy(&checksum, data.data() + 13 + size, sizeof(checksum));
+            if (journal_checksum(data.data(), 13 + size) != checksum) break;
+
+            if (lsn > after_lsn) {
+                fn(static_cast<JournalOp>(data[4]), data.substr(13, size));
+                if (kept) kept->append(data.data(), RECORD_OVERHEAD + size);
+            }
+            last_lsn = std::max(last_lsn, lsn);
+            data.remove_prefix(RECORD_OVERHEAD + size);
+        }
+        if (intact_bytes) *intact_bytes = total - data.size();
+        return last_lsn;
+    }
+};
+
+// =====================================================================
+// Asynchronous Save Pipeline
+// save_async() captures a consistent copy of the records on the calling
+// thread (a compact columnar StudentTable plus the course rows, which is
+// far cheaper than formatting and writing them) and returns a future at
+// once. Two pipeline threads then do the slow part:
+//  - the serializer formats the records into one of two large buffers
+//    that are reused across saves;
+//  - the writer writes the other, filled buffer with a few big write()s
+//    to a temporary file (double buffering: formatting and I/O overlap).
+// Each file is fsync'ed and renamed over the old one, so readers see
+// either the previous or the new file, never a half-written one.
+// =====================================================================
+class SavePipeline {
+public:
+    struct CourseRow {
+        int id;
+        std::string title;
+        int capacity;
+        int enrolled;
+
+        // Same getters as Course, so RecordCodec<Course> can write it
+        inline int get_id() const { return id; }
+        inline const std::string& get_title() const { return title; }
+        inline int get_capacity() const { return capacity; }
+        inline int get_enrolled_students() const { return enrolled; }
+    };
+
+private:
+    static const size_t CHUNK_BYTES = 4 << 20; // Hand a buffer to the writer once it holds this much
+
+    struct Job {
+        std::shared_ptr<const StudentTable> students; // Null: keep the student file as is
+        std::shared_ptr<const std::vector<CourseRow>> courses;
+        std::string student_path, course_path;
+        std::promise<void> done;
+    };
+
+    // One of the two reusable buffers
+    struct Buffer {
+        std::string data;
+        bool full = false; // Handed to the writer, not yet written
+    };
+
+    Buffer buffers[2];
+    size_t filling = 0; // Buffer the serializer appends to
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    int write_fd = -1;
+    bool write_failed = false;
+    bool stopping = false;        // Serializer: exit once the queue is empty
+    bool writer_stopping = false; // Writer: exit (set after the serializer has finished)
+    std::thread serializer;
+    std::thread writer;
+
+    // Writer thread: writes full buffers in order and hands them back
+    void writer_loop() {
+        size_t next = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [&] { return buffers[next].full || writer_stopping; });
+            if (!buffers[next].full) return; // Stopping and nothing left to write
+            int fd = write_fd;
+            bool skip = write_failed;
+            lock.unlock();
+            bool ok = skip || write_fully(fd, buffers[next].data.data(), buffers[next].data.size());
+            lock.lock();
+            if (!ok) write_failed = true;
+            buffers[next].data.clear(); // Keeps its capacity for the next save
+            buffers[next].full = false;
+            next ^= 1;
+            cv.notify_all();
+        }
+    }
+
+    // Passes the filling buffer to the writer and switches to the other one (waits if it is still being written)
+    void hand_off() {
+        std::unique_lock<std::mutex> lock(mutex);
+        buffers[filling].full = true;
+        cv.notify_all();
+        filling ^= 1;
+        cv.wait(lock, [&] { return !buffers[filling].full; });
+    }
+
+    // Waits until every handed-off buffer is written; returns false if a write failed
+    bool drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return !buffers[0].full && !buffers[1].full; });
+        return !write_failed;
+    }
+
+    // Streams one file through the buffers: temp file, format(), fsync, rename
+    template <typename Format>
+    void write_file(const std::string& path, Format format) {
+        std::string tmp_path;
+        int fd = create_temp_file(path, tmp_path);
+        if (fd < 0) throw SystemException("Could not create a temporary file for " + path + ".");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            write_fd = fd;
+            write_failed = false;
+        }
+        try {
+            format();
+        } catch (...) {
+            hand_off(); // Let the writer finish with the partial data so both buffers are free again
+            drain();
+            ::close(fd);
+            std::remove(tmp_path.c_str());
+            throw;
+        }
+        hand_off();
+        bool ok = drain() && ::fsync(fd) == 0;
+        ok = (::close(fd) == 0) && ok;
+        if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            throw SystemException("Could not write " + path + ".");
+        }
+    }
+
+    void save_students(const StudentTable& table, const std::string& path) {
+        write_file(path, [&] {
+            for (size_t row = 0; row < table.size(); ++row) {
+                std::string& out = buffers[filling].data;
+                RecordCodec<Student>::append_text(out, table.row(row));
+                out += '\n';
+                if (out.size() >= CHUNK_BYTES) hand_off();
+            }
+        });
+    }
+
+    void save_courses(const std::vector<CourseRow>& rows, const std::string& path) {
+        write_file(path, [&] {
+            for (const CourseRow& row : rows) {
+                std::string& out = buffers[filling].data;
+                RecordCodec<Course>::append_text(out, row);
+                out += '\n';
+                if (out.size() >= CHUNK_BYTES) hand_off();
+            }
+        });
+    }
+
+    void serializer_loop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !jobs.empty() || stopping; });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            try {
+                UMS_TIME(Timer::SaveAsync);
+                if (job.students) save_students(*job.students, job.student_path);
+                if (job.courses) save_courses(*job.courses, job.course_path);
+                UMS_COUNT(Counter::StudentsSaved, job.students ? job.students->size() : 0);
+                UMS_COUNT(Counter::CoursesSaved, job.courses ? job.courses->size() : 0);
+                job.done.set_value();
+            } catch (...) {
+                job.done.set_exception(std::current_exception());
+            }
+        }
+    }
+
+public:
+    SavePipeline() {
+        for (Buffer& buffer : buffers) buffer.data.reserve(CHUNK_BYTES + 4096);
+        serializer = std::thread(&SavePipeline::serializer_loop, this);
+        writer = std::thread(&SavePipeline::writer_loop, this);
+    }
+
+    SavePipeline(const SavePipeline&) = delete;
+    SavePipeline& operator=(const SavePipeline&) = delete;
+
+    // Finishes every queued save, then stops the threads
+    ~SavePipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        serializer.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writer_stopping = true;
+        }
+        cv.notify_all();
+        writer.join();
+    }
+
+    // Copies the course rows (the seat counts are read atomically)
+    static std::shared_ptr<const std::vector<CourseRow>> capture(const std::vector<Course*>& course_list) {
+        auto rows = std::make_shared<std::vector<CourseRow>>();
+        rows->reserve(course_list.size());
+        for (const Course* c : course_list) {
+            rows->push_back(CourseRow{c->get_id(), c->get_title(), c->get_capacity(), c->get_enrolled_students()});
+        }
+        return rows;
+    }
+
+    // Queues a save; a null table or course list leaves that file untouched
+    std::future<void> submit(std::shared_ptr<const StudentTable> students, const std::string& student_path,
+                             std::shared_ptr<const std::vector<CourseRow>> courses, const std::string& course_path) {
+        Job job;
+        job.students = std::move(students);
+        job.courses = std::move(courses);
+        job.student_path = student_path;
+        job.course_path = course_path;
+        std::future<void> result = job.done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        cv.notify_all();
+        return result;
+    }
+};
+
+// =====================================================================
+// MODULE 2, 5: DatabaseManager Class
+// Demonstrates Friend Class, Stream Class, and File Handling
+// =====================================================================
+class DatabaseManager {
+private:
+    const std::string STUDENT_FILE;
+    const std::string COURSE_FILE;
+    const std::string SNAPSHOT_FILE;
+    const std::string JOURNAL_FILE;
+
+    std::unique_ptr<Journal> journal; // Open after recover()
+    std::unique_ptr<SavePipeline> save_pipeline; // Started by the first save_async()
+    std::shared_future<void> compaction; // Last compact(); the journal must outlive it
+
+    // Blocks until the last compact() has finished (its errors reach the caller's copy of the future)
+    void wait_for_compaction() {
+        if (compaction.valid()) compaction.wait();
+    }
+
+    // One record for both sides, so a crash can never keep the seat without the student
+    void log_enrollment(int student_id, int course_id, bool seat_taken) {
+        JournalWriter out;
+        out.write_int(student_id);
+        out.write_int(course_id);
+        out.write_u32(seat_taken ? 1 : 0);
+        journal->append(JournalOp::Enroll, out.bytes());
+    }
+
+    void log_unenrollment(int student_id, int course_id, bool seat_released) {
+        JournalWriter out;
+        out.write_int(student_id);
+        out.write_int(course_id);
+        out.write_u32(seat_released ? 1 : 0);
+        journal->append(JournalOp::Unenroll, out.bytes());
+    }
+
+    void log_course_enrollment(int course_id) {
+        JournalWriter out;
+        out.write_int(course_id);
+        journal->append(JournalOp::CourseEnrollment, out.bytes());
+    }
+
+    // Formats records record_at(0 .. count-1) on the shared pool, a window of
+    // blocks at a time, and writes the blocks in order. The block buffers are
+    // reused across windows, so memory stays bounded for any record count.
+    template <typename Record, typename RecordAt>
+    static void write_lines(std::ostream& out, size_t count, RecordAt record_at) {
+        const size_t BLOCK_RECORDS = 8192;
+        ThreadPool& pool = ThreadPool::shared();
+        std::vector<std::string> blocks(pool.size() * 2);
+        for (size_t window = 0; window < count; window += BLOCK_RECORDS * blocks.size()) {
+            size_t block_count = std::min(blocks.size(), (count - window + BLOCK_RECORDS - 1) / BLOCK_RECORDS);
+            pool.parallel_for(0, block_count, [&](size_t lo, size_t hi) {
+                for (size_t b = lo; b < hi; ++b) {
+                    std::string& text = blocks[b];
+                    text.clear();
+                    size_t first = window + b * BLOCK_RECORDS, last = std::min(count, first + BLOCK_RECORDS);
+                    for (size_t i = first; i < last; ++i) {
+                        RecordCodec<Record>::append_text(text, record_at(i));
+                        text += '\n';
+                    }
+                }
+            }, 1);
+            for (size_t b = 0; b < block_count; ++b) out.write(blocks[b].data(), static_cast<std::streamsize>(blocks[b].size()));
+        }
+    }
+
+    // A corrupt line found by a parser thread, reported after the parse phase
+    struct ParseError {
+        size_t line; // Line number inside the chunk
+        std::string_view text;
+        const char* reason;
+    };
+
+    // Per-thread output of the parallel loaders. Rows hold views into the mapped file.
+    template <typename Row>
+    struct ParsedChunk {
+        std::vector<Row> rows;
+        std::vector<int> course_ids; // Flat course-ID storage referenced by student rows
+        std::vector<ParseError> errors;
+        size_t line_count = 0;
+    };
+
+    struct StudentRow {
+        StudentRecordView record;
+        size_t first_course; // Offset into ParsedChunk::course_ids
+        size_t course_count;
+    };
+
+    static double ms_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static unsigned pick_thread_count(unsigned requested, size_t bytes) {
+        unsigned threads = requested ? requested : static_cast<unsigned>(ThreadPool::shared().size());
+        // Small files are not worth a thread each: keep at least 256 KB per chunk
+        size_t max_useful = std::max<size_t>(1, bytes / (256 * 1024));
+        return static_cast<unsigned>(std::min<size_t>(threads, max_useful));
+    }
+
+    // Parses every chunk as its own task on the shared pool with parse_line(line, chunk) -> error or nullptr
+    template <typename Row, typename ParseLine>
+    static std::vector<ParsedChunk<Row>> parse_chunks(const std::vector<std::string_view>& chunks, ParseLine parse_line) {
+        std::vector<ParsedChunk<Row>> parsed(chunks.size());
+        auto work = [&](size_t i) {
+            UMS_TRACE_SPAN("db.parse_chunk");
+            std::string_view data = chunks[i];
+            ParsedChunk<Row>& out = parsed[i];
+            while (!data.empty()) {
+                std::string_view line = next_line(data);
+                out.line_count++;
+                if (line.empty()) continue;
+                if (const char* error = parse_line(line, out)) {
+                    out.errors.push_back(ParseError{out.line_count, line, error});
+                }
+            }
+        };
+
+        TaskGroup group(ThreadPool::shared());
+        for (size_t i = 1; i < chunks.size(); ++i) {
+            group.run([&work, i] { work(i); });
+        }
+        if (!chunks.empty()) work(0); // The calling thread takes the first chunk
+        group.wait();
+        return parsed;
+    }
+
+    // Reports corrupt lines in file order, translating chunk-local line numbers
+    template <typename Row>
+    static size_t report_parse_errors(const std::vector<ParsedChunk<Row>>& parsed) {
+        size_t first_line = 0, skipped = 0;
+        for (const ParsedChunk<Row>& chunk : parsed) {
+            for (const ParseError& e : chunk.errors) {
+                UMS_LOG(LogLevel::Error) << "[DB ERROR] Corrupt data line " << first_line + e.line << " skipped: " << e.text
+                                         << " (" << e.reason << ")";
+            }
+            first_line += chunk.line_count;
+            skipped += chunk.errors.size();
+        }
+        UMS_COUNT(Counter::CorruptLines, skipped);
+        return skipped;
+    }
+
+    // Serializes the whole database into the binary snapshot layout
+    static std::string build_snapshot_image(RecordList<Student>& student_list, const std::vector<Course*>& course_list,
+                                            uint64_t journal_lsn) {
+        UMS_TRACE_SPAN("db.build_snapshot_image");
+        const std::vector<Student>& students = student_list.get_records();
+
+        std::vector<SnapshotStudent> student_rows;
+        std::vector<SnapshotCourse> course_rows;
+        std::vector<int32_t> course_ids;
+        std::string pool;
+        student_rows.reserve(students.size());
+        course_rows.reserve(course_list.size());
+
+        for (const Student& s : students) {
+            SnapshotStudent row{};
+            row.id = s.user_id;
+            row.roll = s.roll_number;
+            row.name_offset = pool.size();
+            row.name_length = static_cast<uint32_t>(s.name.size());
+            row.first_course = course_ids.size();
+            row.course_count = static_cast<uint32_t>(s.enrolled_course_ids.size());
+            pool += s.name;
+            course_ids.insert(course_ids.end(), s.enrolled_course_ids.begin(), s.enrolled_course_ids.end());
+            student_rows.push_back(row);
+        }
+        for (const Course* c : course_list) {
+            SnapshotCourse row{};
+            row.id = c->course_id;
+            row.capacity = c->capacity;
+            row.enrolled = c->enrolled_students;
+            row.title_offset = pool.size();
+            row.title_length = static_cast<uint32_t>(c->title.size());
+            pool += c->title;
+            course_rows.push_back(row);
+        }
+
+        SnapshotHeader header{};
+        std::copy(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 8, header.magic);
+        header.version = SNAPSHOT_VERSION;
+        header.byte_order = SNAPSHOT_BYTE_ORDER;
+        header.student_count = student_rows.size();
+        header.course_count = course_rows.size();
+        header.course_id_count = course_ids.size();
+        header.string_pool_size = pool.size();
+        header.next_roll_number = Student::next_roll_number;
+        header.journal_lsn = journal_lsn;
+
+        std::string image;
+        image.reserve(sizeof(header) + student_rows.size() * sizeof(SnapshotStudent) +
+                      course_rows.size() * sizeof(SnapshotCourse) + course_ids.size() * sizeof(int32_t) + pool.size());
+        image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        image.append(reinterpret_cast<const char*>(student_rows.data()), student_rows.size() * sizeof(SnapshotStudent));
+        image.append(reinterpret_cast<const char*>(course_rows.data()), course_rows.size() * sizeof(SnapshotCourse));
+        image.append(reinterpret_cast<const char*>(course_ids.data()), course_ids.size() * sizeof(int32_t));
+        image.append(pool);
+        return image;
+    }
+
+    // Writes 'bytes' to a temporary file, fsyncs it and renames it over 'path'
+    static void write_file_atomically(const std::string& path, const std::string& bytes) {
+        UMS_TRACE_SPAN("db.write_file_atomically");
+        std::string tmp_path;
+        int fd = create_temp_file(path, tmp_path);
+        if (fd < 0) {
+            throw SystemException("Could not create a temporary file for " + path + ".");
+        }
+        bool ok = write_fully(fd, bytes.data(), bytes.size()) && ::fsync(fd) == 0;
+        ok = (::close(fd) == 0) && ok;
+        if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            throw SystemException("Could not write " + path + ".");
+        }
+    }
+
+    // Shared by load_students_parallel() and load_dataset(): the parse phase is the
+    // same, make_record(record, first_course, last_course) builds each stored record
+    template <typename Record, typename MakeRecord>
+    LoadTimings load_students_chunked(RecordList<Record>& student_list, unsigned thread_count, MakeRecord make_record) {
+        UMS_TIME(Timer::LoadStudentsParallel);
+        LoadTimings timings;
+        student_list.clear();
+
+        auto start = std::chrono::steady_clock::now();
+        MappedFile file(STUDENT_FILE);
+        if (!file.is_open()) {
+            UMS_LOG(LogLevel::Info) << "\n[DB] Student file not found. Starting with empty database.";
+            return timings;
+        }
+        timings.threads = pick_thread_count(thread_count, file.view().size());
+        std::vector<std::string_view> chunks = split_at_newlines(file.view(), timings.threads);
+        timings.map_ms = ms_since(start);
+
+        start = std::chrono::steady_clock::now();
+        auto parsed = parse_chunks<StudentRow>(chunks, [](std::string_view line, ParsedChunk<StudentRow>& out) {
+            StudentRow row;
+            const char* error = parse_student_line(line, row.record);
+            if (error) return error;
+            row.first_course = out.course_ids.size();
+            error = for_each_course_id(row.record.course_ids, [&](int course_id) {
+                auto first = out.course_ids.begin() + row.first_course;
+                if (std::find(first, out.course_ids.end(), course_id) == out.course_ids.end()) {
+                    out.course_ids.push_back(course_id);
+                }
+            });
+            if (error) {
+                out.course_ids.resize(row.first_course); // Drop the partial list
+                return error;
+            }
+            row.course_count = out.course_ids.size() - row.first_course;
+            out.rows.push_back(row);
+            return static_cast<const char*>(nullptr);
+        });
+        timings.parse_ms = ms_since(start);
+
+        start = std::chrono::steady_clock::now();
+        timings.skipped = report_parse_errors(parsed);
+        size_t total = 0;
+        for (const auto& chunk : parsed) total += chunk.rows.size();
+        student_list.reserve(total);
+
+        int max_roll = 0;
+        for (const auto& chunk : parsed) {
+            for (const StudentRow& row : chunk.rows) {
+                const int* first = chunk.course_ids.data() + row.first_course;
+                student_list.add_record(make_record(row.record, first, first + row.course_count), false);
+                max_roll = std::max(max_roll, row.record.roll);
+            }
+        }
+        Student::reconcile_roll_counter(max_roll);
+        timings.merge_ms = ms_since(start);
+        timings.records = student_list.count();
+        UMS_COUNT(Counter::StudentsLoaded, timings.records);
+
+        UMS_LOG(LogLevel::Info) << "[DB] Student records loaded successfully (parallel). Total: " << timings.records
+                                << " | threads: " << timings.threads << " | map " << timings.map_ms << " ms, parse "
+                                << timings.parse_ms << " ms, merge " << timings.merge_ms << " ms";
+        return timings;
+    }
+
+public:
+    // 'file_prefix' is put in front of every file name, e.g. "shards/shard0."
+    // gives a shard its own student file, snapshot and journal
+    explicit DatabaseManager(const std::string& file_prefix = "")
+        : STUDENT_FILE(file_prefix + "student_records.txt"),
+          COURSE_FILE(file_prefix + "course_records.txt"),
+          SNAPSHOT_FILE(file_prefix + "university.snapshot"),
+          JOURNAL_FILE(file_prefix + "university.journal") {}
+
+    ~DatabaseManager() {
+        wait_for_compaction();
+    }
+
+    // Builds a Student from a parsed record (repeated course IDs are dropped, as
+    // Student::enroll() would). The static roll counter is left alone, as in the bulk loaders.
+    static Student make_student(const StudentRecordView& record) {
+        Student s(Student::BulkLoadTag{}, record.name, record.id, record.roll);
+        const char* error = for_each_course_id(record.course_ids, [&](int course_id) {
+            if (!simd_contains(s.enrolled_course_ids, course_id)) s.enrolled_course_ids.push_back(course_id);
+        });
+        if (error) throw SystemException(std::string("Invalid student record: ") + error);
+        return s;
+    }
+
+    // MODULE 5: File Handling (Writing to file - Stream Class usage)
+    void save_students(RecordList<Student>& student_list) {
+        UMS_TIME(Timer::SaveStudents);
+        // Written to a temporary file, fsynced and renamed, so a failed save never leaves a half-written file
+        std::ofstream outfile; // Stream Class
+        std::string tmp_path = open_temp_stream(STUDENT_FILE, outfile);
+        if (!outfile.is_open()) {
+            // MODULE 5: Exception Handling (Throwing for file error)
+            throw SystemException("Could not open student file for writing.");
+        }
+
+        const std::vector<Student>& students = student_list.get_records();
+        write_lines<Student>(outfile, students.size(), [&](size_t i) -> const Student& { return students[i]; });
+        outfile.close();
+        if (!commit_temp_file(tmp_path, STUDENT_FILE, !outfile.fail())) {
+            throw SystemException("Could not write " + STUDENT_FILE + ".");
+        }
+        UMS_COUNT(Counter::StudentsSaved, student_list.count());
+        UMS_LOG(LogLevel::Info) << "\n[DB] Student records saved successfully.";
+    }
+
+    // MODULE 5: File Handling (Reading from file - Stream Class usage)
+    void load_students(RecordList<Student>& student_list) {
+        UMS_TIME(Timer::LoadStudents);
+        student_list.clear();
+        std::ifstream infile(STUDENT_FILE); // Stream Class
+
+        if (!infile.is_open()) {
+            UMS_LOG(LogLevel::Info) << "\n[DB] Student file not found. Starting with empty database.";
+            return;
+        }
+
+        std::string line;
+        while (std::getline(infile, line)) {
+            if (line.empty()) continue;
+
+            // Field layout comes from RecordSchema<Student>
+            StudentRecordView record;
+            const char* error = parse_student_line(line, record);
+            if (!error) {
+                error = for_each_course_id(record.course_ids, [](int) {}); // Check the list before enrolling
+            }
+            if (error) {
+                UMS_LOG(LogLevel::Error) << "[DB ERROR] Corrupt data line skipped: " << line << " (" << error << ")";
+                UMS_COUNT(Counter::CorruptLines, 1);
+                continue;
+            }
+
+            // Constructor that takes roll number for loading
+            Student s(std::string(record.name), record.id, record.roll);
+
+            // Load enrolled courses
+            for_each_course_id(record.course_ids, [&](int course_id) {
+                s.enroll(course_id); // Uses Function Overloading
+            });
+            student_list.add_record(std::move(s), false); // Add loaded student to list
+        }
+        infile.close();
+        UMS_COUNT(Counter::StudentsLoaded, student_list.count());
+        UMS_LOG(LogLevel::Info) << "[DB] Student records loaded successfully. Total: " << student_list.count();
+    }
+
+    // Faster loader: memory-maps the file and parses every field in place.
+    // Corrupt lines are skipped and reported with their line number.
+    void load_students_mapped(RecordList<Student>& student_list) {
+        UMS_TIME(Timer::LoadStudentsMapped);
+        student_list.clear();
+        MappedFile file(STUDENT_FILE);
+
+        if (!file.is_open()) {
+            UMS_LOG(LogLevel::Info) << "\n[DB] Student file not found. Starting with empty database.";
+            return;
+        }
+
+        std::string_view data = file.view();
+        student_list.reserve(static_cast<size_t>(std::count(data.begin(), data.end(), '\n')) + 1);
+
+        StudentRecordView record;
+        std::vector<int> course_ids; // Reused for every line
+        size_t line_number = 0;
+        int max_roll = 0;
+        while (!data.empty()) {
+            std::string_view line = next_line(data);
+            line_number++;
+            if (line.empty()) continue;
+
+            course_ids.clear();
+            const char* error = parse_student_line(line, record);
+            if (!error) {
+                error = for_each_course_id(record.course_ids, [&](int course_id) {
+                    // Same duplicate check as Student::enroll(int), without the console output
+                    if (std::find(course_ids.begin(), course_ids.end(), course_id) == course_ids.end()) {
+                        course_ids.push_back(course_id);
+                    }
+                });
+            }
+            if (error) {
+                UMS_LOG(LogLevel::Error) << "[DB ERROR] Corrupt data line " << line_number << " skipped: " << line
+                                         << " (" << error << ")";
+                UMS_COUNT(Counter::CorruptLines, 1);
+                continue;
+            }
+
+            Student s(Student::BulkLoadTag{}, record.name, record.id, record.roll);
+            s.enrolled_course_ids.assign(course_ids.begin(), course_ids.end());
+            student_list.add_record(std::move(s), false);
+            max_roll = std::max(max_roll, record.roll);
+        }
+        Student::reconcile_roll_counter(max_roll);
+        UMS_COUNT(Counter::StudentsLoaded, student_list.count());
+        UMS_LOG(LogLevel::Info) << "[DB] Student records loaded successfully (mapped). Total: " << student_list.count();
+    }
+    
+    // Parallel loader: splits the mapped file at newline boundaries, parses each
+    // chunk on its own thread, then merges the results in original file order.
+    // The static roll counter is reconciled once at the end.
+    LoadTimings load_students_parallel(RecordList<Student>& student_list, unsigned thread_count = 0) {
+        return load_students_chunked(student_list, thread_count, [](const StudentRecordView& record, const int* first,
+                                                                    const int* last) {
+            Student s(Student::BulkLoadTag{}, record.name, record.id, record.roll);
+            s.enrolled_course_ids.assign(first, last);
+            return s;
+        });
+    }
+
+    // Parallel load into an arena-backed dataset (previous contents and arena memory are released first)
+    LoadTimings load_dataset(StudentDataset& dataset, unsigned thread_count = 0) {
+        dataset.reset();
+        std::pmr::memory_resource* arena = dataset.resource();
+        return load_students_chunked(dataset.records(), thread_count, [arena](const StudentRecordView& record,
+                                                                              const int* first, const int* last) {
+            StudentDataset::Row row(record.id, record.name, record.roll, arena);
+            row.course_ids.assign(first, last);
+            return row;
+        });
+    }
+
+    // Lazy mode: indexes the student file without building any Student (defined after LazyStudentStore)
+    size_t open_lazy(LazyStudentStore& store);
+
+    // Streaming query over the student file (nothing is loaded into a RecordList)
+    StudentQuery query_students(size_t buffer_size = 1 << 20) const {
+        return StudentQuery(STUDENT_FILE, buffer_size);
+    }
+
+    // Course counterpart of load_students_parallel()
+    LoadTimings load_courses_parallel(RecordList<Course>& course_list, unsigned thread_count = 0) {
+        UMS_TIME(Timer::LoadCoursesParallel);
+        LoadTimings timings;
+        course_list.clear();
+
+        auto start = std::chrono::steady_clock::now();
+        MappedFile file(COURSE_FILE);
+        if (!file.is_open()) {
+            UMS_LOG(LogLevel::Info) << "\n[DB] Course file not found. Starting with empty course list.";
+            return timings;
+        }
+        timings.threads = pick_thread_count(thread_count, file.view().size());
+        std::vector<std::string_view> chunks = split_at_newlines(file.view(), timings.threads);
+        timings.map_ms = ms_since(start);
+
+        start = std::chrono::steady_clock::now();
+        auto parsed = parse_chunks<CourseRecordView>(chunks, [](std::string_view line, ParsedChunk<CourseRecordView>& out) {
+            CourseRecordView record;
+            const char* error = parse_course_line(line, record);
+            if (!error) out.rows.push_back(record);
+            return error;
+        });
+        timings.parse_ms = ms_since(start);
+
+        start = std::chrono::steady_clock::now();
+        timings.skipped = report_parse_errors(parsed);
+        for (const auto& chunk : parsed) {
+            for (const CourseRecordView& record : chunk.rows) {
+                Course c(record.id, std::string(record.title), record.capacity);
+                c.enrolled_students = record.enrolled;
+                course_list.add_record(c, false);
+            }
+        }
+        timings.merge_ms = ms_since(start);
+        timings.records = course_list.count();
+        UMS_COUNT(Counter::CoursesLoaded, timings.records);
+
+        UMS_LOG(LogLevel::Info) << "[DB] Course records loaded successfully. Total: " << timings.records
+                                << " | threads: " << timings.threads << " | map " << timings.map_ms << " ms, parse "
+                                << timings.parse_ms << " ms, merge " << timings.merge_ms << " ms";
+        return timings;
+    }
+
+    void load_courses(RecordList<Course>& course_list) {
+        load_courses_parallel(course_list, 1);
+    }
+
+    // Simple course saving (for demonstration)
+    void save_courses(const std::vector<Course*>& course_list) {
+        UMS_TIME(Timer::SaveCourses);
+        std::ofstream outfile; // Fsynced and renamed into place like save_students()
+        std::string tmp_path = open_temp_stream(COURSE_FILE, outfile);
+        if (!outfile.is_open()) {
+            throw SystemException("Could not open course file for writing.");
+        }
+
+        write_lines<Course>(outfile, course_list.size(), [&](size_t i) -> const Course& { return *course_list[i]; });
+        outfile.close();
+        if (!commit_temp_file(tmp_path, COURSE_FILE, !outfile.fail())) {
+            throw SystemException("Could not write " + COURSE_FILE + ".");
+        }
+        UMS_COUNT(Counter::CoursesSaved, course_list.size());
+        UMS_LOG(LogLevel::Info) << "[DB] Course records saved successfully.";
+    }
+
+    // Asynchronous save of both record files. The records are copied before this
+    // returns, so the caller can keep enrolling while the files are written; the
+    // future becomes ready (or holds the SystemException) once both are renamed
+    // into place. Saves complete in the order they were requested.
+    std::future<void> save_async(RecordList<Student>& student_list, const std::vector<Course*>& course_list) {
+        auto students = std::make_shared<const StudentTable>(StudentTable::from_records(student_list));
+        auto courses = SavePipeline::capture(course_list);
+        if (!save_pipeline) save_pipeline = std::make_unique<SavePipeline>();
+        return save_pipeline->submit(std::move(students), STUDENT_FILE, std::move(courses), COURSE_FILE);
+    }
+
+    // Binary backend: writes students and courses into one snapshot file.
+    // The image is assembled in memory, written to a temporary file and renamed
+    // over the old snapshot, so a failed save never leaves a half-written file.
+    void save_snapshot(RecordList<Student>& student_list, const std::vector<Course*>& course_list) {
+        save_snapshot(student_list, course_list, SNAPSHOT_FILE);
+    }
+
+    void save_snapshot(RecordList<Student>& student_list, const std::vector<Course*>& course_list,
+                       const std::string& path) {
+        UMS_TIME(Timer::SaveSnapshot);
+        uint64_t journal_lsn = journal ? journal->last_lsn() : 0;
+        write_file_atomically(path, build_snapshot_image(student_list, course_list, journal_lsn));
+        UMS_LOG(LogLevel::Info) << "[DB] Snapshot saved successfully. Students: " << student_list.count()
+                                << ", Courses: " << course_list.size();
+    }
+
+    // Loads a snapshot with a single mmap. Every record is read from its fixed
+    // offset, so there is no text parsing at all.
+    // Returns the journal LSN the snapshot covers (0 if none).
+    uint64_t load_snapshot(RecordList<Student>& student_list, RecordList<Course>& course_list) {
+        return load_snapshot(student_list, course_list, SNAPSHOT_FILE);
+    }
+
+    uint64_t load_snapshot(RecordList<Student>& student_list, RecordList<Course>& course_list, const std::string& path) {
+        UMS_TIME(Timer::LoadSnapshot);
+        student_list.clear();
+        course_list.clear();
+        MappedFile file(path);
+        if (!file.is_open()) {
+            UMS_LOG(LogLevel::Info) << "\n[DB] Snapshot file not found. Starting with empty database.";
+            return 0;
+        }
+
+        std::string_view data = file.view();
+        SnapshotHeader header;
+        if (data.size() < sizeof(header)) {
+            throw SystemException("Snapshot file is truncated.");
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (!std::equal(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 8, header.magic)) {
+            throw SystemException("Not a snapshot file: " + path);
+        }
+        if (header.byte_order != SNAPSHOT_BYTE_ORDER) {
+            throw SystemException("Snapshot was written on a machine with a different byte order.");
+        }
+        if (header.version > SNAPSHOT_VERSION) {
+            throw SystemException("Snapshot version " + std::to_string(header.version) + " is not supported.");
+        }
+
+        // Each section has to fit in what is left of the file. Counts are compared
+        // by division before anything is multiplied, so a corrupt header cannot
+        // wrap the offsets around and pass the check.
+        size_t remaining = data.size() - sizeof(SnapshotHeader);
+        auto section = [&](uint64_t count, size_t width, size_t& at) {
+            at = data.size() - remaining;
+            if (count > remaining / width) return false;
+            remaining -= static_cast<size_t>(count) * width;
+            return true;
+        };
+        size_t students_at, courses_at, course_ids_at, pool_at;
+        if (!section(header.student_count, sizeof(SnapshotStudent), students_at) ||
+            !section(header.course_count, sizeof(SnapshotCourse), courses_at) ||
+            !section(header.course_id_count, sizeof(int32_t), course_ids_at) ||
+            !section(header.string_pool_size, 1, pool_at)) {
+            throw SystemException("Snapshot file is truncated.");
+        }
+
+        // The mapping is page aligned and every section starts on a multiple of 4 bytes
+        const SnapshotStudent* students = reinterpret_cast<const SnapshotStudent*>(data.data() + students_at);
+        const SnapshotCourse* courses = reinterpret_cast<const SnapshotCourse*>(data.data() + courses_at);
+        const int32_t* course_ids = reinterpret_cast<const int32_t*>(data.data() + course_ids_at);
+        const char* pool = data.data() + pool_at;
+
+        student_list.reserve(header.student_count);
+        for (uint64_t i = 0; i < header.student_count; ++i) {
+            const SnapshotStudent& row = students[i];
+            // Written as subtractions so that huge offsets cannot wrap around
+            if (row.name_offset > header.string_pool_size || row.name_length > header.string_pool_size - row.name_offset ||
+                row.first_course > header.course_id_count || row.course_count > header.course_id_count - row.first_course) {
+                throw SystemException("Snapshot student record " + std::to_string(i) + " is out of bounds.");
+            }
+            Student s(Student::BulkLoadTag{}, std::string_view(pool + row.name_offset, row.name_length), row.id, row.roll);
+            s.enrolled_course_ids.assign(course_ids + row.first_course, course_ids + row.first_course + row.course_count);
+            student_list.add_record(std::move(s), false);
+        }
+        Student::reconcile_roll_counter(header.next_roll_number - 1);
+
+        course_list.reserve(header.course_count);
+        for (uint64_t i = 0; i < header.course_count; ++i) {
+            const SnapshotCourse& row = courses[i];
+            if (row.title_offset > header.string_pool_size ||
+                row.title_length > header.string_pool_size - row.title_offset) {
+                throw SystemException("Snapshot course record " + std::to_string(i) + " is out of bounds.");
+            }
+            Course c(row.id, std::string(pool + row.title_offset, row.title_length), row.capacity);
+            c.enrolled_students = std::max(0, std::min(row.enrolled, row.capacity)); // Never restore an over-full course
+            course_list.add_record(c, false);
+        }
+        UMS_COUNT(Counter::StudentsLoaded, student_list.count());
+        UMS_COUNT(Counter::CoursesLoaded, course_list.count());
+        UMS_LOG(LogLevel::Info) << "[DB] Snapshot loaded successfully. Students: " << student_list.count()
+                                << ", Courses: " << course_list.count();
+        return header.version >= 2 ? header.journal_lsn : 0;
+    }
+
+    // ---------------------------------------------------------------
+    // Write-ahead journal: mutations are appended to the journal instead
+    // of rewriting the record files. recover() rebuilds the state from
+    // snapshot + journal tail, and compact() folds the journal into a new
+    // snapshot in the background.
+    // ---------------------------------------------------------------
+
+    // Takes a seat on replay. The snapshot is clamped to capacity, so the
+    // journal is never trusted to stay under it either.
+    static void replay_seat(RecordList<Course>& course_list, int course_id) {
+        Course* c = course_list.find_record(course_id);
+        if (c && !c->try_reserve_seat()) {
+            UMS_LOG(LogLevel::Error) << "[DB ERROR] Journal takes a seat in full course " << course_id << "; ignored.";
+        }
+    }
+
+    // Loads the snapshot, replays newer journal records and opens the journal for appends
+    uint64_t recover(RecordList<Student>& student_list, RecordList<Course>& course_list) {
+        UMS_TIME(Timer::Recover);
+        wait_for_compaction(); // It may still be trimming the journal we are about to replace
+        journal.reset();
+        uint64_t snapshot_lsn = load_snapshot(student_list, course_list);
+        student_list.enable_index();
+        course_list.enable_index();
+
+        int max_roll = 0;
+        size_t replayed = 0;
+        uint64_t last_lsn = Journal::replay(JOURNAL_FILE, snapshot_lsn, [&](JournalOp op, std::string_view payload) {
+            JournalReader in(payload);
+            if (op == JournalOp::AddStudent) {
+                int id = in.read_int(), roll = in.read_int();
+                std::string_view name = in.read_string();
+                Student s(Student::BulkLoadTag{}, name, id, roll);
+                for (uint32_t n = in.read_u32(); n > 0; --n) {
+                    s.enrolled_course_ids.push_back(in.read_int());
+                }
+                student_list.remove_record(id); // A later record for the same ID replaces it (ShardServer's Put)
+                student_list.add_record(std::move(s), false);
+                max_roll = std::max(max_roll, roll);
+            } else if (op == JournalOp::Enroll) {
+                int student_id = in.read_int(), course_id = in.read_int();
+                bool seat_taken = !in.at_end() && in.read_u32() != 0;
+                Student* s = student_list.find_record(student_id);
+                if (s && !simd_contains(s->enrolled_course_ids, course_id)) {
+                    s->add_course_id(course_id);
+                    if (seat_taken) replay_seat(course_list, course_id);
+                }
+            } else if (op == JournalOp::CourseEnrollment) {
+                replay_seat(course_list, in.read_int());
+            } else if (op == JournalOp::Unenroll) {
+                int student_id = in.read_int(), course_id = in.read_int();
+                bool seat_released = in.read_u32() != 0;
+                Student* s = student_list.find_record(student_id);
+                if (s && s->remove_course_id(course_id) && seat_released) {
+                    if (Course* c = course_list.find_record(course_id)) c->release_seat();
+                }
+            }
+            replayed++;
+        });
+        Student::reconcile_roll_counter(max_roll);
+
+        if (size_t dropped = Journal::truncate_torn_tail(JOURNAL_FILE)) {
+            UMS_LOG(LogLevel::Error) << "[DB ERROR] Discarded " << dropped << " bytes of torn journal tail.";
+        }
+        journal = std::make_unique<Journal>(JOURNAL_FILE, std::max(snapshot_lsn, last_lsn) + 1);
+        UMS_LOG(LogLevel::Info) << "[DB] Recovery complete. Snapshot LSN: " << snapshot_lsn << ", journal records replayed: "
+                                << replayed;
+        return std::max(snapshot_lsn, last_lsn);
+    }
+
+    // Journaled mutation: adds the student to the list and appends one record
+    void add_student(RecordList<Student>& student_list, const Student& s) {
+        student_list.add_record(s, false);
+        if (journal) {
+            JournalWriter out;
+            out.write_int(s.user_id);
+            out.write_int(s.roll_number);
+            out.write_string(s.name);
+            out.write_u32(static_cast<uint32_t>(s.enrolled_course_ids.size()));
+            for (int course_id : s.enrolled_course_ids) out.write_int(course_id);
+            journal->append(JournalOp::AddStudent, out.bytes());
+        }
+    }
+
+    // Journaled mutation: Student::enroll(Course&) (counts the seat and records the course)
+    void enroll(Student& s, Course& course) {
+        size_t before = s.enrolled_course_ids.size();
+        s.enroll(course);
+        if (journal && s.enrolled_course_ids.size() != before) {
+            log_enrollment(s.user_id, course.get_id(), true);
+        }
+    }
+
+    // Journaled mutation: Student::enroll(int)
+    void enroll(Student& s, int course_id) {
+        size_t before = s.enrolled_course_ids.size();
+        s.enroll(course_id);
+        if (journal && s.enrolled_course_ids.size() != before) {
+            log_enrollment(s.user_id, course_id, false);
+        }
+    }
+
+    // Journaled mutation: Student::unenroll(Course&) (also gives the seat back)
+    bool unenroll(Student& s, Course& course) {
+        bool removed = s.unenroll(course);
+        if (journal && removed) log_unenrollment(s.user_id, course.get_id(), true);
+        return removed;
+    }
+
+    // Journaled mutation: Student::unenroll(int)
+    bool unenroll(Student& s, int course_id) {
+        bool removed = s.unenroll(course_id);
+        if (journal && removed) log_unenrollment(s.user_id, course_id, false);
+        return removed;
+    }
+
+    // Journaled mutation: Course::increment_enrollment()
+    void increment_enrollment(Course& course) {
+        course.increment_enrollment();
+        if (journal) log_course_enrollment(course.get_id());
+    }
+
+    // Blocks until every journal record appended so far is on disk
+    void sync_journal() {
+        if (journal) journal->wait_durable(journal->last_lsn());
+    }
+
+    // Folds the journal into a fresh snapshot. The image is built on the calling
+    // thread (so it is consistent), then written and the journal trimmed on a
+    // background thread. Records appended meanwhile stay in the journal.
+    // One compaction runs at a time, and recover() and the destructor wait for
+    // it, so the journal it trims is never replaced or freed underneath it.
+    std::shared_future<void> compact(RecordList<Student>& student_list, const std::vector<Course*>& course_list) {
+        wait_for_compaction(); // An older image must not land after this one
+        uint64_t lsn = journal ? journal->last_lsn() : 0;
+        auto image = std::make_shared<std::string>(build_snapshot_image(student_list, course_list, lsn));
+        Journal* target = journal.get();
+        std::string snapshot_path = SNAPSHOT_FILE;
+        compaction = std::async(std::launch::async, [image, target, lsn, snapshot_path]() {
+            write_file_atomically(snapshot_path, *image);
+            // A crash before this point is harmless: replay skips records <= the snapshot's LSN
+            if (target) target->discard_through(lsn);
+        }).share();
+        return compaction;
+    }
+
+    // Converter: text record files -> binary snapshot
+    void convert_text_to_snapshot() {
+        RecordList<Student> students;
+        RecordList<Course> courses;
+        load_students_parallel(students);
+        load_courses_parallel(courses);
+        save_snapshot(students, course_pointers(courses));
+    }
+
+    // Converter: binary snapshot -> text record files
+    void convert_snapshot_to_text() {
+        RecordList<Student> students;
+        RecordList<Course> courses;
+        load_snapshot(students, courses);
+        save_students(students);
+        save_courses(course_pointers(courses));
+    }
+
+    // The save functions take Course pointers (as used by main); adapts a RecordList
+    static std::vector<Course*> course_pointers(RecordList<Course>& course_list) {
+        std::vector<Course*> pointers;
+        for (Course& c : course_list.get_records()) {
+            pointers.push_back(&c);
+        }
+        return pointers;
+    }
+};
+
+// =====================================================================
+// Lazy Student Store
+// Starts up without building every Student: open() maps the student file
+// and builds only a table of (ID, offset, length) for its lines, sorted by
+// ID. A Student is parsed the first time find_record() or an enrollment
+// touches it.
+//  - the table comes from a scan that parses just the ID and roll number
+//    of each line, or from the sidecar <file>.idx that the scan leaves
+//    behind. The sidecar is used in place (mapped, not copied) while the
+//    file's size, mtime and inode still match, so open() does no per-record
+//    work. A sidecar line that turns out to hold another ID (a rewrite that
+//    kept all three) makes the store drop the sidecar and scan again;
+//  - hydrated students sit in an LRU cache. A capacity of 0 keeps every
+//    one of them; otherwise the least recently used is dropped when the
+//    cache is full. Changed students that get dropped are parked as text
+//    lines (not Student objects) until the next save();
+//  - save() copies untouched lines straight from the mapping, so it does
+//    not hydrate anything.
+// Only the ID and roll number are checked at open(); a line that is
+// corrupt elsewhere throws SystemException when it is hydrated.
+// With a bounded cache, a pointer from find_record() is valid until the
+// next call that hydrates another student.
+// =====================================================================
+class LazyStudentStore {
+private:
+    // Where one student's line is in the file
+    struct Location {
+        uint64_t offset;
+        uint32_t length;
+        int32_t id;
+    };
+
+    // Sidecar layout: this header, then 'count' Location entries sorted by ID
+    struct SidecarHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t source_size;
+        int64_t source_mtime_ns;
+        uint64_t source_inode;
+        uint64_t count;
+        uint64_t skipped;
+        int32_t max_roll;
+        uint32_t reserved;
+    };
+    static constexpr char SIDECAR_MAGIC[8] = {'U', 'M', 'S', 'L', 'I', 'D', 'X', '\0'};
+    static constexpr uint32_t SIDECAR_VERSION = 2;
+
+    struct Cached {
+        Student student;
+        bool dirty; // Differs from its line in the file (always true for added students)
+    };
+
+    std::string path;
+    std::unique_ptr<MappedFile> file;
+    std::unique_ptr<MappedFile> sidecar; // Backs 'table' when it came from the sidecar
+    std::vector<Location> owned;         // Backs 'table' after a scan or save()
+    const Location* table = nullptr;     // Lines of the file, sorted by ID
+    size_t table_size = 0;
+    std::vector<int> added;              // Students added since open()/save(), in order
+
+    std::list<Cached> lru; // Most recently used first
+    std::unordered_map<int, std::list<Cached>::iterator> cached;
+    std::unordered_map<int, std::string> parked; // Changed students evicted from the cache, as text lines
+    size_t capacity;
+    size_t skipped = 0; // Lines whose ID or roll number could not be read, and duplicate IDs
+    bool from_sidecar = false;
+
+    std::string sidecar_path() const { return path + ".idx"; }
+
+    // What the sidecar records about the file it indexes
+    struct SourceStamp {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t inode = 0;
+    };
+
+    static bool stat_file(const std::string& file_path, SourceStamp& stamp) {
+        struct stat st;
+        if (::stat(file_path.c_str(), &st) != 0) return false;
+        stamp.size = static_cast<uint64_t>(st.st_size);
+        stamp.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        stamp.inode = static_cast<uint64_t>(st.st_ino);
+        return true;
+    }
+
+    static bool by_id(const Location& a, const Location& b) { return a.id < b.id; }
+
+    const Location* locate(int id) const {
+        const Location* end = table + table_size;
+        const Location* at = std::lower_bound(table, end, Location{0, 0, id}, by_id);
+        return (at != end && at->id == id) ? at : nullptr;
+    }
+
+    void use_owned() {
+        sidecar.reset();
+        table = owned.data();
+        table_size = owned.size();
+    }
+
+    // Newline and first-field scan: nothing past the roll number is parsed
+    int scan(std::string_view data) {
+        const char* base = data.data();
+        size_t line_number = 0;
+        int max_roll = 0;
+        while (!data.empty()) {
+            std::string_view line = next_line(data);
+            line_number++;
+            if (line.empty()) continue;
+
+            std::string_view rest = line;
+            std::string_view id_field = next_field(rest, '|');
+            next_field(rest, '|'); // Name
+            int id, roll;
+            if (!parse_int(id_field, id) || !parse_int(next_field(rest, '|'), roll)) {
+                UMS_LOG(LogLevel::Error) << "[DB ERROR] Corrupt data line " << line_number << " skipped: " << line;
+                UMS_COUNT(Counter::CorruptLines, 1);
+                skipped++;
+                continue;
+            }
+            owned.push_back(Location{static_cast<uint64_t>(line.data() - base), static_cast<uint32_t>(line.size()), id});
+            max_roll = std::max(max_roll, roll);
+        }
+
+        // Files written in ID order (the common case) are already sorted. On a
+        // duplicate ID the stable sort keeps the first line, as find_record() does.
+        if (!std::is_sorted(owned.begin(), owned.end(), by_id)) {
+            std::stable_sort(owned.begin(), owned.end(), by_id);
+        }
+        auto last = std::unique(owned.begin(), owned.end(), [](const Location& a, const Location& b) {
+            return a.id == b.id;
+        });
+        if (last != owned.end()) {
+            size_t duplicates = static_cast<size_t>(owned.end() - last);
+            UMS_LOG(LogLevel::Error) << "[DB ERROR] " << duplicates << " line(s) with a duplicate student ID skipped.";
+            skipped += duplicates;
+            owned.erase(last, owned.end());
+        }
+        use_owned();
+        return max_roll;
+    }
+
+    bool load_sidecar(const SourceStamp& source, int& max_roll) {
+        auto mapped = std::make_unique<MappedFile>(sidecar_path());
+        std::string_view data = mapped->view();
+        SidecarHeader header;
+        if (data.size() < sizeof(header)) return false;
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (!std::equal(SIDECAR_MAGIC, SIDECAR_MAGIC + 8, header.magic) || header.version != SIDECAR_VERSION ||
+            header.byte_order != SNAPSHOT_BYTE_ORDER || header.source_size != source.size ||
+            header.source_mtime_ns != source.mtime_ns || header.source_inode != source.inode) {
+            return false; // Stale or foreign: fall back to a scan
+        }
+        // Divide before multiplying, so a damaged count cannot wrap around and pass
+        size_t room = (data.size() - sizeof(header)) / sizeof(Location);
+        if (header.count > room || data.size() != sizeof(header) + static_cast<size_t>(header.count) * sizeof(Location)) {
+            return false;
+        }
+
+        // The mapping is page aligned and the header size is a multiple of 8
+        sidecar = std::move(mapped);
+        table = reinterpret_cast<const Location*>(sidecar->view().data() + sizeof(header));
+        table_size = header.count;
+        skipped = header.skipped;
+        max_roll = header.max_roll;
+        return true;
+    }
+
+    // Best effort: without a sidecar the next open() simply scans again
+    void write_sidecar(int max_roll) {
+        SourceStamp source;
+        if (!stat_file(path, source)) return;
+
+        SidecarHeader header{};
+        std::copy(SIDECAR_MAGIC, SIDECAR_MAGIC + 8, header.magic);
+        header.version = SIDECAR_VERSION;
+        header.byte_order = SNAPSHOT_BYTE_ORDER;
+        header.source_size = source.size;
+        header.source_mtime_ns = source.mtime_ns;
+        header.source_inode = source.inode;
+        header.count = table_size;
+        header.skipped = skipped;
+        header.max_roll = max_roll;
+
+        std::string tmp_path;
+        int fd = create_temp_file(sidecar_path(), tmp_path);
+        bool ok = fd >= 0 && write_fully(fd, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+                  write_fully(fd, reinterpret_cast<const char*>(table), table_size * sizeof(Location));
+        if (fd >= 0) ok = (::close(fd) == 0) && ok;
+        if (fd < 0 || !commit_temp_file(tmp_path, sidecar_path(), ok)) {
+            UMS_LOG(LogLevel::Error) << "[DB ERROR] Could not write offset sidecar " << sidecar_path() << ".";
+        }
+    }
+
+    // Drops a sidecar table that no longer matches the file, scans the file
+    // and replaces the sidecar. Lines already hydrated or parked are kept.
+    void rescan() {
+        UMS_LOG(LogLevel::Error) << "[DB ERROR] Offset sidecar " << sidecar_path() << " does not match " << path
+                                 << "; rescanning.";
+        owned.clear();
+        skipped = 0;
+        int max_roll = scan(file->view());
+        write_sidecar(max_roll);
+        Student::reconcile_roll_counter(max_roll);
+    }
+
+    void evict_over_capacity() {
+        while (capacity && lru.size() > capacity) {
+            Cached& victim = lru.back();
+            int id = victim.student.get_id();
+            if (victim.dirty) parked[id] = RecordCodec<Student>::to_text(victim.student);
+            cached.erase(id);
+            lru.pop_back();
+            UMS_COUNT(Counter::LazyEvictions, 1);
+        }
+    }
+
+    // Returns the cached student, parsing its line first if needed (nullptr: unknown ID)
+    Cached* hydrate(int id) {
+        auto hit = cached.find(id);
+        if (hit != cached.end()) {
+            lru.splice(lru.begin(), lru, hit->second);
+            return &*hit->second;
+        }
+
+        auto park = parked.find(id);
+        bool dirty = park != parked.end();
+        std::string_view line;
+        if (dirty) {
+            line = park->second;
+        } else {
+            const Location* at = locate(id);
+            if (!at) return nullptr;
+            if (at->offset + at->length > file->view().size()) {
+                if (sidecar) {
+                    rescan();
+                    return hydrate(id);
+                }
+                throw SystemException("Offset table does not match " + path + ".");
+            }
+            line = file->view().substr(at->offset, at->length);
+        }
+
+        StudentRecordView record;
+        const char* error = parse_student_line(line, record);
+        if (!dirty && sidecar && (error || record.id != id)) {
+            rescan(); // The sidecar outlived the file it was written for
+            return hydrate(id);
+        }
+        if (error) {
+            throw SystemException("Corrupt student record for ID " + std::to_string(id) + " (" + error + ")");
+        }
+        if (record.id != id) {
+            throw SystemException("Offset table does not match " + path + " for ID " + std::to_string(id) + ".");
+        }
+        lru.push_front(Cached{DatabaseManager::make_student(record), dirty});
+        if (dirty) parked.erase(park); // Only now: 'line' pointed into it
+        cached.emplace(id, lru.begin());
+        UMS_COUNT(Counter::LazyHydrations, 1);
+        evict_over_capacity();
+        return &lru.front();
+    }
+
+    // Appends the current text of one student: re-encoded if changed, else copied from the file
+    void append_line(std::string& out, int id, const Location* at) const {
+        auto hit = cached.find(id);
+        if (hit != cached.end() && hit->second->dirty) {
+            RecordCodec<Student>::append_text(out, hit->second->student);
+            return;
+        }
+        auto park = parked.find(id);
+        if (park != parked.end()) {
+            out += park->second;
+        } else if (at) {
+            out.append(file->view().data() + at->offset, at->length);
+        }
+    }
+
+public:
+    // 'cache_capacity' bounds the number of hydrated students (0: unbounded)
+    explicit LazyStudentStore(size_t cache_capacity = 0) : capacity(cache_capacity) {}
+
+    // Maps 'file_path' and builds (or loads) the offset table. Returns the number of students indexed.
+    size_t open(const std::string& file_path) {
+        UMS_TIME(Timer::OpenLazy);
+        path = file_path;
+        owned.clear();
+        use_owned();
+        added.clear();
+        lru.clear();
+        cached.clear();
+        parked.clear();
+        skipped = 0;
+        from_sidecar = false;
+
+        SourceStamp source;
+        bool exists = stat_file(path, source);
+        file = std::make_unique<MappedFile>(path);
+        if (!exists || !file->is_open()) {
+            UMS_LOG(LogLevel::Info) << "\n[DB] Student file not found. Starting with empty database.";
+            return 0;
+        }
+
+        int max_roll = 0;
+        from_sidecar = file->view().size() == source.size && load_sidecar(source, max_roll);
+        if (!from_sidecar) {
+            max_roll = scan(file->view());
+            write_sidecar(max_roll);
+        }
+        file->advise_random(); // From here on lines are read one at a time, in request order
+        Student::reconcile_roll_counter(max_roll);
+        UMS_LOG(LogLevel::Info) << "[DB] Student offsets indexed (" << (from_sidecar ? "sidecar" : "scan")
+                                << "). Total: " << table_size;
+        return table_size;
+    }
+
+    // Hydrates the student on first use
+    const Student* find_record(int id) {
+        UMS_TIME_SAMPLED(Timer::FindRecord);
+        UMS_COUNT(Counter::RecordLookups, 1);
+        if (Cached* entry = hydrate(id)) return &entry->student;
+        UMS_COUNT(Counter::RecordLookupMisses, 1);
+        return nullptr;
+    }
+
+    // Known ID? Answered without hydrating
+    bool contains(int id) const {
+        return locate(id) || cached.count(id) || parked.count(id);
+    }
+
+    // Student::enroll(Course&) on the hydrated student. Returns false if the ID is unknown.
+    bool enroll(int student_id, Course& course) {
+        Cached* entry = hydrate(student_id);
+        if (!entry) return false;
+        size_t before = entry->student.course_count();
+        entry->student.enroll(course);
+        entry->dirty |= entry->student.course_count() != before;
+        return true;
+    }
+
+    // Student::enroll(int). Returns false if the ID is unknown.
+    bool enroll(int student_id, int course_id) {
+        Cached* entry = hydrate(student_id);
+        if (!entry) return false;
+        size_t before = entry->student.course_count();
+        entry->student.enroll(course_id);
+        entry->dirty |= entry->student.course_count() != before;
+        return true;
+    }
+
+    // Student::unenroll(Course&) (gives the seat back). Returns false if nothing was removed.
+    bool unenroll(int student_id, Course& course) {
+        Cached* entry = hydrate(student_id);
+        if (!entry || !entry->student.unenroll(course)) return false;
+        entry->dirty = true;
+        return true;
+    }
+
+    // New students go straight into the cache; they reach the file on save()
+    void add_student(const Student& s) {
+        if (contains(s.get_id())) {
+            throw SystemException("Student ID " + std::to_string(s.get_id()) + " already exists.");
+        }
+        added.push_back(s.get_id());
+        lru.push_front(Cached{s, true});
+        cached.emplace(s.get_id(), lru.begin());
+        evict_over_capacity();
+    }
+
+    // Rewrites the student file in its original line order, added students
+    // last. Unchanged students are copied byte for byte; changed ones are
+    // re-encoded. The new file is renamed into place and remapped, and the
+    // sidecar rewritten, so the store stays open with a clean cache.
+    void save() {
+        UMS_TIME(Timer::SaveLazy);
+        if (!file) throw SystemException("Lazy student store is not open.");
+        std::ofstream out;
+        std::string tmp_path = open_temp_stream(path, out, std::ios::binary);
+        if (!out.is_open()) {
+            throw SystemException("Could not open student file for writing.");
+        }
+
+        // The table is in ID order; the file is written in its own line order
+        std::vector<uint32_t> file_order(table_size);
+        for (size_t i = 0; i < table_size; ++i) file_order[i] = static_cast<uint32_t>(i);
+        auto by_offset = [this](uint32_t a, uint32_t b) { return table[a].offset < table[b].offset; };
+        if (!std::is_sorted(file_order.begin(), file_order.end(), by_offset)) {
+            std::sort(file_order.begin(), file_order.end(), by_offset);
+        }
+
+        const size_t FLUSH_BYTES = 1 << 20;
+        std::vector<Location> written(table_size);
+        std::vector<Location> appended;
+        std::string block;
+        uint64_t flushed = 0;
+        int max_roll = 0; // Largest roll number in the new file, for the sidecar
+        auto emit = [&](int id, const Location* at) {
+            size_t start = block.size();
+            append_line(block, id, at);
+            Location line{flushed + start, static_cast<uint32_t>(block.size() - start), id};
+            std::string_view rest(block.data() + start, line.length);
+            next_field(rest, '|'); // ID
+            next_field(rest, '|'); // Name
+            int roll;
+            if (parse_int(next_field(rest, '|'), roll)) max_roll = std::max(max_roll, roll);
+            block += '\n';
+            if (block.size() >= FLUSH_BYTES) {
+                out.write(block.data(), static_cast<std::streamsize>(block.size()));
+                flushed += block.size();
+                block.clear();
+            }
+            return line;
+        };
+        for (uint32_t i : file_order) written[i] = emit(table[i].id, &table[i]);
+        for (int id : added) appended.push_back(emit(id, nullptr));
+        out.write(block.data(), static_cast<std::streamsize>(block.size()));
+        out.close();
+        if (!commit_temp_file(tmp_path, path, !out.fail())) {
+            throw SystemException("Could not write " + path + ".");
+        }
+
+        std::sort(appended.begin(), appended.end(), by_id);
+        owned.clear();
+        owned.reserve(written.size() + appended.size());
+        std::merge(written.begin(), written.end(), appended.begin(), appended.end(), std::back_inserter(owned), by_id);
+        use_owned();
+        file = std::make_unique<MappedFile>(path);
+        file->advise_random();
+        added.clear();
+        parked.clear();
+        for (Cached& entry : lru) entry.dirty = false;
+        write_sidecar(max_roll);
+        UMS_COUNT(Counter::StudentsSaved, table_size);
+        UMS_LOG(LogLevel::Info) << "[DB] Student records saved (lazy). Total: " << table_size;
+    }
+
+    // Changes the cache bound (evicting at once if it shrinks)
+    void set_cache_capacity(size_t cache_capacity) {
+        capacity = cache_capacity;
+        evict_over_capacity();
+    }
+
+    inline size_t count() const { return table_size + added.size(); }
+    inline size_t hydrated_count() const { return lru.size(); }
+    inline size_t parked_count() const { return parked.size(); }
+    inline size_t skipped_count() const { return skipped; }
+    inline bool opened_from_sidecar() const { return from_sidecar; }
+};
+
+inline size_t DatabaseManager::open_lazy(LazyStudentStore& store) {
+    return store.open(STUDENT_FILE);
+}
+
+// =====================================================================
+// Sharded Mode
+// Partitions the students over N shards by a hash of the user ID. Each
+// shard is a separate process with its own RecordList<Student>, snapshot
+// and journal (<directory>/shard<k>.university.*), so the student set is
+// no longer bound to a single process:
+//  - ShardServer runs inside a shard process and answers requests on a
+//    Unix stream socket;
+//  - ShardRouter sends each lookup, enrollment and save to the shard that
+//    owns the student (ShardMap);
+//  - SeatCoordinator owns the course seat counts for every shard. An
+//    enrollment reserves a seat first, then asks the owning shard, then
+//    commits the reservation, or releases it if the shard refused, so no
+//    course is over-filled across shards. If the lease ran out while the
+//    shard worked, the router takes the seat again or undoes the
+//    enrollment. If the request failed in transit the outcome is unknown:
+//    the seat stays held until ShardRouter::resolve_in_doubt() has asked
+//    the shard.
+// Durability and reconciliation: the shards are the source of truth. Each
+// journals its adds, enrollments and unenrollments and acknowledges them
+// only once they are on disk. The coordinator's seat counts are not saved
+// separately; they are derived state: ShardRouter::reconcile_seats() sets
+// each course to the enrollments summed over the shards. Run it at startup
+// (and after a crash of the router or a shard), before taking enrollments.
+// Requests are length-prefixed frames in the journal's field encoding, and
+// student records travel in RecordCodec's binary format. Nothing depends on
+// the socket being local: a TCP transport could carry the same frames to
+// shards on other machines.
+// =====================================================================
+enum class ShardOp : uint32_t {
+    Put = 1,      // u32 count, then count binary student records (added or replaced)
+    Find = 2,     // student ID -> binary record
+    Enroll = 3,   // student ID, course ID (the seat is already reserved)
+    Unenroll = 4, // student ID, course ID
+    Save = 5,     // folds the shard's journal into its snapshot
+    Count = 6,    // -> u32 number of students
+    Shutdown = 7,
+    CourseCounts = 8 // -> u32 count, then count (course ID, students enrolled) pairs
+};
+
+// First field of every reply
+enum class ShardStatus : uint32_t { Ok = 0, NotFound = 1, AlreadyEnrolled = 2, NotEnrolled = 3, Failed = 4 };
+
+// Student ID -> shard. Fibonacci hashing spreads consecutive IDs evenly.
+class ShardMap {
+private:
+    size_t shards;
+
+public:
+    explicit ShardMap(size_t count) : shards(count) {
+        if (count == 0) throw SystemException("A sharded database needs at least one shard.");
+    }
+
+    inline size_t size() const { return shards; }
+
+    inline size_t shard_of(int user_id) const {
+        uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(user_id)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>((hash >> 32) % shards);
+    }
+
+    // File prefix for a shard's DatabaseManager
+    static std::string file_prefix(const std::string& directory, size_t shard) {
+        return directory + "/shard" + std::to_string(shard) + ".";
+    }
+};
+
+// Frames on a stream socket: u32 length, then the payload. MSG_NOSIGNAL
+// turns a peer that went away into an error instead of SIGPIPE.
+inline bool send_frame(int fd, std::string_view payload) {
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    std::string frame(reinterpret_cast<const char*>(&size), sizeof(size));
+    frame.append(payload.data(), payload.size());
+    const char* data = frame.data();
+    size_t left = frame.size();
+    while (left > 0) {
+        ssize_t sent = ::send(fd, data, left, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += sent;
+        left -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+inline bool read_exactly(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = ::read(fd, data, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false; // Error or the peer closed the connection
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// False on end of stream or a broken connection
+inline bool receive_frame(int fd, std::string& payload) {
+    const uint32_t MAX_FRAME = 256u << 20;
+    uint32_t size;
+    if (!read_exactly(fd, reinterpret_cast<char*>(&size), sizeof(size)) || size > MAX_FRAME) return false;
+    payload.resize(size);
+    return read_exactly(fd, &payload[0], size);
+}
+
+inline sockaddr_un unix_address(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) throw SystemException("Socket path is too long: " + path);
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// Serves one shard: its students live in this process only. Every change
+// is appended to the shard's journal and is durable before it is
+// acknowledged; Save folds the journal into the shard's snapshot.
+class ShardServer {
+private:
+    DatabaseManager db;
+    RecordList<Student> students;
+    RecordList<Course> courses; // Unused: seats are kept by the router's SeatCoordinator
+
+    // Decodes one request and returns the encoded reply
+    std::string handle(std::string_view request, bool& shutdown) {
+        JournalReader in(request);
+        JournalWriter out;
+        switch (static_cast<ShardOp>(in.read_u32())) {
+            case ShardOp::Put: {
+                uint32_t count = in.read_u32();
+                for (uint32_t i = 0; i < count; ++i) {
+                    std::string_view data = in.read_string();
+                    StudentRecordView record;
+                    if (const char* error = RecordCodec<Student>::parse_binary(data, record)) throw SystemException(error);
+                    students.remove_record(record.id); // Replaces an existing copy
+                    db.add_student(students, DatabaseManager::make_student(record));
+                }
+                db.sync_journal();
+                out.write_u32(static_cast<uint32_t>(ShardStatus::Ok));
+                break;
+            }
+            case ShardOp::Find: {
+                const Student* s = students.find_record(in.read_int());
+                out.write_u32(static_cast<uint32_t>(s ? ShardStatus::Ok : ShardStatus::NotFound));
+                if (s) {
+                    std::string record;
+                    RecordCodec<Student>::append_binary(record, *s);
+                    out.write_string(record);
+                }
+                break;
+            }
+            case ShardOp::Enroll: {
+                int student_id = in.read_int(), course_id = in.read_int();
+                Student* s = students.find_record(student_id);
+                ShardStatus status = ShardStatus::NotFound;
+                if (s && simd_contains(s->get_enrolled_course_ids(), course_id)) {
+                    status = ShardStatus::AlreadyEnrolled;
+                } else if (s) {
+                    db.enroll(*s, course_id);
+                    db.sync_journal();
+                    status = ShardStatus::Ok;
+                }
+                out.write_u32(static_cast<uint32_t>(status));
+                break;
+            }
+            case ShardOp::Unenroll: {
+                int student_id = in.read_int(), course_id = in.read_int();
+                Student* s = students.find_record(student_id);
+                ShardStatus status = !s ? ShardStatus::NotFound
+                                        : (db.unenroll(*s, course_id) ? ShardStatus::Ok : ShardStatus::NotEnrolled);
+                if (status == ShardStatus::Ok) db.sync_journal();
+                out.write_u32(static_cast<uint32_t>(status));
+                break;
+            }
+            case ShardOp::Save:
+                db.compact(students, {}).get();
+                out.write_u32(static_cast<uint32_t>(ShardStatus::Ok));
+                break;
+            case ShardOp::Count:
+                out.write_u32(static_cast<uint32_t>(ShardStatus::Ok));
+                out.write_u32(static_cast<uint32_t>(students.count()));
+                break;
+            case ShardOp::CourseCounts: {
+                std::map<int, uint32_t> per_course;
+                for (const Student& s : students.get_records()) {
+                    for (int course_id : s.get_enrolled_course_ids()) per_course[course_id]++;
+                }
+                out.write_u32(static_cast<uint32_t>(ShardStatus::Ok));
+                out.write_u32(static_cast<uint32_t>(per_course.size()));
+                for (const auto& entry : per_course) {
+                    out.write_int(entry.first);
+                    out.write_u32(entry.second);
+                }
+                break;
+            }
+            case ShardOp::Shutdown:
+                shutdown = true;
+                out.write_u32(static_cast<uint32_t>(ShardStatus::Ok));
+                break;
+            default:
+                throw SystemException("Unknown shard request.");
+        }
+        return out.bytes();
+    }
+
+public:
+    // Recovers the shard from '<file_prefix>university.snapshot' and its journal. A
+    // shard with neither (written before the journal) loads its student file instead.
+    explicit ShardServer(const std::string& file_prefix) : db(file_prefix) {
+        db.recover(students, courses);
+        if (students.count() == 0) db.load_students_mapped(students);
+    }
+
+    inline RecordList<Student>& records() { return students; }
+
+    // Accepts connections one at a time and answers their requests until a Shutdown request
+    void serve(const std::string& socket_path) {
+        sockaddr_un address = unix_address(socket_path);
+        int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0) throw SystemException("Could not create shard socket.");
+        ::unlink(socket_path.c_str());
+        if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 8) != 0) {
+            ::close(listener);
+            throw SystemException("Could not listen on " + socket_path);
+        }
+
+        bool shutdown = false;
+        std::string request;
+        while (!shutdown) {
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            while (!shutdown && receive_frame(client, request)) {
+                std::string reply;
+                try {
+                    reply = handle(request, shutdown);
+                } catch (const std::exception& e) {
+                    JournalWriter out;
+                    out.write_u32(static_cast<uint32_t>(ShardStatus::Failed));
+                    out.write_string(e.what());
+                    reply = out.bytes();
+                }
+                if (!send_frame(client, reply)) break;
+            }
+            ::close(client);
+        }
+        ::close(listener);
+        ::unlink(socket_path.c_str());
+    }
+};
+
+// Entry point of a shard process: ums shard <socket path> <file prefix>
+inline int run_shard_process(const std::string& socket_path, const std::string& file_prefix) {
+    Logger::set_level(LogLevel::Warn); // Per-enrollment messages belong to the router's console, not the shard's
+    try {
+        ShardServer server(file_prefix);
+        server.serve(socket_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[SHARD ERROR] " << socket_path << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// The router's connection to one shard (one request at a time). A broken
+// connection is closed, and the next request connects again.
+class ShardClient {
+private:
+    std::string endpoint;
+    int fd = -1;
+    std::mutex mutex;
+
+    static ShardStatus check(JournalReader& in, const std::string& endpoint) {
+        ShardStatus status = static_cast<ShardStatus>(in.read_u32());
+        if (status == ShardStatus::Failed) {
+            throw SystemException("Shard " + endpoint + " failed: " + std::string(in.read_string()));
+        }
+        return status;
+    }
+
+    // Retries until the shard listens (it may still be starting) or 'timeout' passes
+    void connect(std::chrono::milliseconds timeout) {
+        sockaddr_un address = unix_address(endpoint);
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true) {
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) throw SystemException("Could not create socket.");
+            if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return;
+            ::close(fd);
+            fd = -1;
+            if (std::chrono::steady_clock::now() > deadline) throw SystemException("Shard " + endpoint + " is not reachable.");
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    void disconnect() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+public:
+    ShardClient(const std::string& socket_path, std::chrono::milliseconds timeout) : endpoint(socket_path) {
+        connect(timeout);
+    }
+
+    ShardClient(const ShardClient&) = delete;
+    ShardClient& operator=(const ShardClient&) = delete;
+
+    ~ShardClient() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    inline const std::string& get_endpoint() const { return endpoint; }
+
+    // Sends one request; the reply's status is checked (Failed throws) and
+    // the rest of the reply is left in 'reply' for the caller to read
+    ShardStatus request(const JournalWriter& message, std::string& reply) {
+        std::lock_guard<std::mutex> lock(mutex);
+        send(message);
+        return receive(reply);
+    }
+
+    // Split halves of request(), used to pipeline one request to every shard
+    // (the caller must hold lock() across both)
+    void send(const JournalWriter& message) {
+        if (fd < 0) connect(std::chrono::milliseconds(100));
+        if (!send_frame(fd, message.bytes())) {
+            disconnect();
+            throw SystemException("Shard " + endpoint + " is not reachable.");
+        }
+    }
+
+    ShardStatus receive(std::string& reply) {
+        if (fd < 0 || !receive_frame(fd, reply)) {
+            disconnect();
+            throw SystemException("Shard " + endpoint + " closed the connection.");
+        }
+        JournalReader in(reply);
+        ShardStatus status = check(in, endpoint);
+        reply.erase(0, sizeof(uint32_t));
+        return status;
+    }
+
+    inline std::mutex& lock() { return mutex; }
+};
+
+// Global course seat counts for all shards. reserve() takes a seat and
+// returns a token; the router then commits it once the owning shard
+// accepted the enrollment, or releases it. A reservation that is neither
+// committed nor released within the lease (a router that died half-way)
+// is returned by expire_stale(). Because the lease can also run out while
+// the shard request is still in flight, commit() reports a token that is
+// no longer pending; the router then retake()s the seat or undoes the
+// enrollment. A reservation whose shard outcome is unknown is put on hold()
+// and never expires until the router settles it.
+class SeatCoordinator {
+private:
+    struct Reservation {
+        int course_id; // Not a Course*: the course list may reallocate while a reservation is open
+        std::chrono::steady_clock::time_point deadline; // time_point::max() while on hold
+    };
+
+    void give_back(int course_id) {
+        if (Course* course = courses.find_record(course_id)) course->release_seat();
+    }
+
+    RecordList<Course>& courses;
+    std::chrono::milliseconds lease;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Reservation> pending;
+    uint64_t next_token = 1;
+
+public:
+    explicit SeatCoordinator(RecordList<Course>& course_list, std::chrono::milliseconds lease_time = std::chrono::seconds(30))
+        : courses(course_list), lease(lease_time) {}
+
+    // 0 if the course does not exist or is full
+    uint64_t reserve(int course_id, EnrollmentResult& failure) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Course* course = courses.find_record(course_id);
+        if (!course) {
+            failure = EnrollmentResult::UnknownCourse;
+            return 0;
+        }
+        if (!course->try_reserve_seat()) {
+            failure = EnrollmentResult::CourseFull;
+            return 0;
+        }
+        uint64_t token = next_token++;
+        pending.emplace(token, Reservation{course_id, std::chrono::steady_clock::now() + lease});
+        return token;
+    }
+
+    // The shard accepted: the seat stays taken. False if the reservation had
+    // already expired and its seat was given back (the seat is not taken).
+    bool commit(uint64_t token) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.erase(token) != 0;
+    }
+
+    // Takes a seat outside any reservation, for an enrollment the shard has
+    // already made; false if the course is full (or unknown)
+    bool retake(int course_id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Course* course = courses.find_record(course_id);
+        return course && course->try_reserve_seat();
+    }
+
+    // The shard's answer is unknown: keep the seat until commit() or release()
+    // settles it. False if the reservation had already expired.
+    bool hold(uint64_t token) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pending.find(token);
+        if (it == pending.end()) return false;
+        it->second.deadline = std::chrono::steady_clock::time_point::max();
+        return true;
+    }
+
+    // The shard refused (or failed): the seat goes back
+    void release(uint64_t token) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pending.find(token);
+        if (it == pending.end()) return; // Already expired
+        give_back(it->second.course_id);
+        pending.erase(it);
+    }
+
+    // A committed seat freed by an unenrollment
+    void release_seat(int course_id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        give_back(course_id);
+    }
+
+    // Releases every reservation whose lease has run out; returns how many
+    size_t expire_stale() {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        size_t expired = 0;
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->second.deadline <= now) {
+                give_back(it->second.course_id);
+                it = pending.erase(it);
+                expired++;
+            } else {
+                ++it;
+            }
+        }
+        return expired;
+    }
+
+    size_t pending_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.size();
+    }
+
+    // Sets every course's seat count to its enrollments on the shards
+    // ('enrolled', by course ID) plus the reservations still open for it
+    void recount(const std::unordered_map<int, int>& enrolled) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<int, int> reserved;
+        for (const auto& entry : pending) reserved[entry.second.course_id]++;
+        for (Course& course : courses.get_records()) {
+            auto on_shards = enrolled.find(course.get_id());
+            auto open = reserved.find(course.get_id());
+            course.enrolled_students.store((on_shards == enrolled.end() ? 0 : on_shards->second) +
+                                           (open == reserved.end() ? 0 : open->second));
+        }
+    }
+};
+
+// Sends each request to the shard that owns the student. Safe to call from
+// several threads (one request per shard connection at a time).
+class ShardRouter {
+private:
+    // An enrollment whose shard request failed in transit: it may or may not have been applied
+    struct InDoubt {
+        uint64_t token; // Held reservation, or 0 if none (it had expired, or the seat was given up)
+        int student_id;
+        int course_id;
+    };
+
+    ShardMap map;
+    std::vector<std::unique_ptr<ShardClient>> shards;
+    SeatCoordinator& seats;
+    std::mutex doubt_mutex;
+    std::vector<InDoubt> in_doubt;
+
+    void add_in_doubt(uint64_t token, int student_id, int course_id) {
+        std::lock_guard<std::mutex> lock(doubt_mutex);
+        in_doubt.push_back({token, student_id, course_id});
+    }
+
+    ShardStatus request_unenroll(int student_id, int course_id) {
+        JournalWriter request = message(ShardOp::Unenroll);
+        request.write_int(student_id);
+        request.write_int(course_id);
+        std::string reply;
+        return shards[map.shard_of(student_id)]->request(request, reply);
+    }
+
+    // The shard enrolled the student but the reservation had expired: take the
+    // seat again, or undo the enrollment if the course filled up meanwhile.
+    // Throws if the undo does not reach the shard (the caller records it as in doubt).
+    EnrollmentResult settle_late_enrollment(int student_id, int course_id) {
+        if (seats.retake(course_id)) return EnrollmentResult::Enrolled;
+        request_unenroll(student_id, course_id);
+        return EnrollmentResult::CourseFull;
+    }
+
+    static JournalWriter message(ShardOp op) {
+        JournalWriter out;
+        out.write_u32(static_cast<uint32_t>(op));
+        return out;
+    }
+
+    // Sends one request to every shard before reading any reply, so the shards work in parallel
+    void broadcast(ShardOp op, std::vector<std::string>& replies) {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (auto& shard : shards) locks.emplace_back(shard->lock());
+        JournalWriter request = message(op);
+        for (auto& shard : shards) shard->send(request);
+        replies.resize(shards.size());
+        for (size_t i = 0; i < shards.size(); ++i) shards[i]->receive(replies[i]);
+    }
+
+public:
+    // One endpoint (socket path) per shard, in shard order
+    ShardRouter(const std::vector<std::string>& endpoints, SeatCoordinator& coordinator,
+                std::chrono::milliseconds connect_timeout = std::chrono::seconds(5))
+        : map(endpoints.size()), seats(coordinator) {
+        for (const std::string& endpoint : endpoints) {
+            shards.push_back(std::make_unique<ShardClient>(endpoint, connect_timeout));
+        }
+    }
+
+    inline size_t shard_count() const { return map.size(); }
+    inline size_t shard_of(int student_id) const { return map.shard_of(student_id); }
+
+    // Adds (or replaces) students on their shards, in batches per shard
+    void import(const RecordList<Student>& student_list) {
+        const size_t BATCH = 4096;
+        std::vector<JournalWriter> batches(shards.size());
+        std::vector<uint32_t> counts(shards.size(), 0);
+        std::string record, reply;
+        auto flush = [&](size_t shard) {
+            JournalWriter request = message(ShardOp::Put);
+            request.write_u32(counts[shard]);
+            request.write_bytes(batches[shard].bytes());
+            shards[shard]->request(request, reply);
+            batches[shard] = JournalWriter();
+            counts[shard] = 0;
+        };
+        for (const Student& s : student_list.get_records()) {
+            size_t shard = map.shard_of(s.get_id());
+            record.clear();
+            RecordCodec<Student>::append_binary(record, s);
+            batches[shard].write_string(record);
+            if (++counts[shard] == BATCH) flush(shard);
+        }
+        for (size_t shard = 0; shard < shards.size(); ++shard) {
+            if (counts[shard] > 0) flush(shard);
+        }
+    }
+
+    inline void add_student(const Student& student) {
+        RecordList<Student> one;
+        one.add_record(student, false);
+        import(one);
+    }
+
+    // A copy of the student's record, fetched from its shard
+    std::optional<Student> find_student(int student_id) {
+        JournalWriter request = message(ShardOp::Find);
+        request.write_int(student_id);
+        std::string reply;
+        if (shards[map.shard_of(student_id)]->request(request, reply) != ShardStatus::Ok) return std::nullopt;
+        JournalReader in(reply);
+        std::string_view data = in.read_string();
+        StudentRecordView record;
+        if (const char* error = RecordCodec<Student>::parse_binary(data, record)) throw SystemException(error);
+        return DatabaseManager::make_student(record);
+    }
+
+    // Reserve a seat with the coordinator, enroll on the owning shard, then commit or release the seat
+    EnrollmentResult enroll(int student_id, int course_id) {
+        EnrollmentResult failure = EnrollmentResult::CourseFull;
+        uint64_t token = seats.reserve(course_id, failure);
+        if (token == 0) return failure;
+
+        JournalWriter request = message(ShardOp::Enroll);
+        request.write_int(student_id);
+        request.write_int(course_id);
+        std::string reply;
+        ShardStatus status;
+        try {
+            status = shards[map.shard_of(student_id)]->request(request, reply);
+        } catch (...) {
+            // The shard may have applied the request before the connection broke:
+            // keep the seat and let resolve_in_doubt() ask the shard
+            add_in_doubt(seats.hold(token) ? token : 0, student_id, course_id);
+            throw;
+        }
+        if (status == ShardStatus::Ok) {
+            if (seats.commit(token)) return EnrollmentResult::Enrolled;
+            try {
+                return settle_late_enrollment(student_id, course_id); // The lease ran out while the shard worked
+            } catch (...) {
+                add_in_doubt(0, student_id, course_id); // Possibly still enrolled on the shard, without a seat
+                throw;
+            }
+        }
+        seats.release(token);
+        return status == ShardStatus::AlreadyEnrolled ? EnrollmentResult::AlreadyEnrolled : EnrollmentResult::UnknownStudent;
+    }
+
+    // Removes the enrollment on the owning shard and frees the seat; false if the student was not enrolled
+    bool unenroll(int student_id, int course_id) {
+        if (request_unenroll(student_id, course_id) != ShardStatus::Ok) return false;
+        seats.release_seat(course_id);
+        return true;
+    }
+
+    // Settles enrollments left in doubt by transport errors: asks the owning
+    // shard whether the student holds the course, then keeps the seat (taking
+    // it again if the reservation is gone, or undoing the enrollment if the
+    // course is full) or frees it. A shard serves one connection at a time, so
+    // its answer comes after the lost request was handled. Entries whose shard
+    // is still unreachable are kept; returns how many remain.
+    size_t resolve_in_doubt() {
+        std::vector<InDoubt> open;
+        {
+            std::lock_guard<std::mutex> lock(doubt_mutex);
+            open.swap(in_doubt);
+        }
+        std::vector<InDoubt> unresolved;
+        for (const InDoubt& entry : open) {
+            InDoubt next = entry;
+            try {
+                std::optional<Student> student = find_student(entry.student_id);
+                bool enrolled = student && simd_contains(student->get_enrolled_course_ids(), entry.course_id);
+                if (!enrolled) {
+                    if (entry.token) seats.release(entry.token);
+                } else if (!(entry.token && seats.commit(entry.token))) {
+                    next.token = 0; // No reservation left: the seat has to be taken again
+                    settle_late_enrollment(entry.student_id, entry.course_id);
+                }
+            } catch (const SystemException&) {
+                unresolved.push_back(next);
+            }
+        }
+        std::lock_guard<std::mutex> lock(doubt_mutex);
+        in_doubt.insert(in_doubt.end(), unresolved.begin(), unresolved.end());
+        return in_doubt.size();
+    }
+
+    // Rebuilds the coordinator's seat counts from the shards (the durable
+    // side): settles in-doubt enrollments, then recounts every course. Call it
+    // with no enrollment in flight, e.g. at startup. Throws if a shard is unreachable.
+    void reconcile_seats() {
+        resolve_in_doubt();
+        seats.recount(course_enrollments());
+    }
+
+    // Students enrolled per course, summed over every shard
+    std::unordered_map<int, int> course_enrollments() {
+        std::vector<std::string> replies;
+        broadcast(ShardOp::CourseCounts, replies);
+        std::unordered_map<int, int> result;
+        for (const std::string& reply : replies) {
+            JournalReader in(reply);
+            for (uint32_t n = in.read_u32(); n > 0; --n) {
+                int course_id = in.read_int();
+                result[course_id] += static_cast<int>(in.read_u32());
+            }
+        }
+        return result;
+    }
+
+    // Every shard writes its own student file (in parallel)
+    void save_all() {
+        std::vector<std::string> replies;
+        broadcast(ShardOp::Save, replies);
+    }
+
+    // Students per shard
+    std::vector<size_t> counts() {
+        std::vector<std::string> replies;
+        broadcast(ShardOp::Count, replies);
+        std::vector<size_t> result;
+        for (const std::string& reply : replies) {
+            JournalReader in(reply);
+            result.push_back(in.read_u32());
+        }
+        return result;
+    }
+
+    // Asks every shard process to exit (after finishing the request in hand)
+    void shutdown_all() {
+        std::vector<std::string> replies;
+        broadcast(ShardOp::Shutdown, replies);
+    }
+};
+
+// N shard processes on this machine, each started as
+// '<this program> shard <socket> <file prefix>' with its files and socket
+// in 'directory'. The destructor waits for them to exit (after
+// ShardRouter::shutdown_all()) and stops any that are still running.
+class LocalShardCluster {
+private:
+    std::vector<pid_t> pids;
+    std::vector<std::string> sockets;
+
+public:
+    LocalShardCluster(size_t count, const std::string& directory) {
+        if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw SystemException("Could not create shard directory " + directory);
+        }
+        for (size_t shard = 0; shard < count; ++shard) {
+            // Everything the child needs is prepared before fork(): only exec follows in the child
+            std::string socket_path = directory + "/shard" + std::to_string(shard) + ".sock";
+            std::string prefix = ShardMap::file_prefix(directory, shard);
+            ::unlink(socket_path.c_str()); // A stale socket would let the router connect too early
+            pid_t pid = ::fork();
+            if (pid < 0) throw SystemException("Could not start a shard process.");
+            if (pid == 0) {
+                ::execl("/proc/self/exe", "ums", "shard", socket_path.c_str(), prefix.c_str(), static_cast<char*>(nullptr));
+                ::_exit(127);
+            }
+            pids.push_back(pid);
+            sockets.push_back(socket_path);
+        }
+    }
+
+    LocalShardCluster(const LocalShardCluster&) = delete;
+    LocalShardCluster& operator=(const LocalShardCluster&) = delete;
+
+    ~LocalShardCluster() {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        for (pid_t pid : pids) {
+            while (::waitpid(pid, nullptr, WNOHANG) == 0) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    ::kill(pid, SIGTERM);
+                    ::waitpid(pid, nullptr, 0);
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+    }
+
+    inline const std::vector<std::string>& endpoints() const { return sockets; }
+};
+
+#ifndef UMS_BENCHMARK
+// =====================================================================
+// MAIN FUNCTION (Demonstration of all concepts)
+// =====================================================================
+int main(int argc, char* argv[]) {
+    // Shard process mode, started by LocalShardCluster: ums shard <socket> <file prefix>
+    if (argc == 4 && std::string(argv[1]) == "shard") return run_shard_process(argv[2], argv[3]);
+
+    std::cout << "=== University Management System (RTU Syllabus Project) ===" << std::endl;
+    std::cout << "Demonstrating C++ OOP concepts from Classes/Objects to File Handling." << std::endl;
+    std::cout << "----------------------------------------------------------------" << std::endl;
+#if UMS_METRICS
+    Metrics::start_tracing(); // Record spans for the whole demo
+#endif
+
+    // --- MODULE 1, 4, 5: Classes, Objects, Static, Operator Overloading, Exceptions ---
+    std::cout << "\n[Module 1/4/5: Course and Objects]" << std::endl;
+
+    // Creation of Course Objects (demonstrates Constructor)
+    Course math_c(101, "Advanced Mathematics", 40);
+    Course cs_c(201, "Data Structures & Algos"); // Uses default argument for capacity (30)
+
+    // Demonstrates Operator Overloading (<<) and Static Member Function
+    std::cout << cs_c << std::endl;
+    std::cout << "Total Courses Created (Static): " << Course::get_total_courses() << std::endl;
+    
+    // Use an Array/Vector of Pointers to Course objects (for easier management)
+    std::vector<Course*> available_courses;
+    available_courses.push_back(&math_c);
+    available_courses.push_back(&cs_c);
+
+    // Demonstrate Exception Handling (Attempting to enroll in a full course)
+    try {
+        for (int i = 0; i < 30; ++i) {
+            cs_c.increment_enrollment();
+        }
+        // FIX: Accessing private member via public getter function
+        std::cout << "[Test] Current CS enrollment: " << cs_c.get_enrolled_students() << std::endl;
+        
+        // This will throw the exception defined in Course::increment_enrollment()
+        cs_c.increment_enrollment(); 
+    } catch (const SystemException& e) {
+        // Catch block demonstrates Module 5 requirement
+        std::cerr << "\n[EXCEPTION CAUGHT]: " << e.what() << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Standard Exception: " << e.what() << std::endl;
+    }
+    std::cout << "----------------------------------------------------------------" << std::endl;
+
+    // --- MODULE 3, 4: Inheritance, Polymorphism, Dynamic Binding, Abstract Class ---
+    std::cout << "\n[Module 3/4: Inheritance, Polymorphism & Abstract Class]" << std::endl;
+
+    // Creation of Derived Objects
+    Student s1("Alice Smith", 5001); // Uses Static Member to assign Roll No 1001
+    Student s2("Bob Johnson", 5002); // Uses Static Member to assign Roll No 1002
+    Faculty f1("Dr. Chen", 7001, "Computer Science");
+    
+    // Demonstrate Static Member Function of Student
+    std::cout << "Total Students Created (Static): " << Student::get_total_students() << std::endl;
+    
+    // Polymorphism and Dynamic Binding demonstration (using User* pointers)
+    std::vector<User*> users;
+    users.push_back(&s1);
+    users.push_back(&f1);
+
+    for (const auto& user_ptr : users) {
+        // Calls the correct display_details() based on the actual object type (Dynamic Binding)
+        user_ptr->display_details();
+    }
+
+    // The same users in a type-partitioned UserStore: contiguous arrays, static dispatch
+    {
+        UserStore store;
+        store.add(s1);
+        store.add(f1);
+        if (std::optional<UserRef> found = store.find(7001)) {
+            std::visit(Overloaded{
+                [](Student* s) { std::cout << "UserStore: 7001 is student roll " << s->get_roll_number() << std::endl; },
+                [](Faculty* f) { std::cout << "UserStore: 7001 is faculty in " << f->get_department() << std::endl; }},
+                *found);
+        }
+        std::cout << "UserStore users with a 'Dr.' title: "
+                  << store.count_if([](const auto& user) { return user.get_name().substr(0, 3) == "Dr."; }) << std::endl;
+    }
+    std::cout << "----------------------------------------------------------------" << std::endl;
+
+    // --- MODULE 2: Function Overloading, Reference, Friend Class ---
+    std::cout << "\n[Module 2: Overloading, Enrollment & Friend Class Setup]" << std::endl;
+
+    // Demonstrate Function Overloading
+    s1.enroll(101);         // Calls enroll(int)
+    s2.enroll(math_c);      // Calls enroll(const Course&), demonstrating reference usage
+    s2.enroll(cs_c);        // Demonstrates the enrollment system (might catch the 'full' exception)
+    
+    f1.assign_course(&math_c); // Dynamic Memory Usage (Pointer to Course)
+    
+    // --- MODULE 5: Template Class and File Handling ---
+    std::cout << "\n[Module 5: Template & File Handling]" << std::endl;
+
+    // Demonstrates Template Class
+    RecordList<Student> student_db;
+    student_db.add_record(s1);
+    student_db.add_record(s2);
+    
+    DatabaseManager db_manager;
+    
+    // Demonstrates File Handling (Writing to file)
+    try {
+        db_manager.save_students(student_db); // Uses Friend Class access to save private Student data
+        db_manager.save_courses(available_courses);
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Same save in the background: the records are copied, then written by the save pipeline
+    try {
+        std::future<void> saved = db_manager.save_async(student_db, available_courses);
+        saved.get(); // Rethrows a SystemException if the save failed
+        std::cout << "[DB] Asynchronous save complete." << std::endl;
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+    
+    // --- Post-Save/Load Demonstration ---
+    std::cout << "\n--- DEMONSTRATING LOAD (New DB object created) ---" << std::endl;
+    RecordList<Student> loaded_student_db;
+    
+    // Demonstrates File Handling (Reading from file)
+    try {
+        db_manager.load_students(loaded_student_db);
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Same file through the memory-mapped, zero-copy loader
+    RecordList<Student> mapped_student_db;
+    try {
+        db_manager.load_students_mapped(mapped_student_db);
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Parallel chunked load of both record files (reports map/parse/merge timings)
+    RecordList<Student> parallel_student_db;
+    RecordList<Course> loaded_course_db;
+    try {
+        db_manager.load_students_parallel(parallel_student_db);
+        db_manager.load_courses_parallel(loaded_course_db);
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Streaming query: roster of course 101 straight from the file, reading only IDs and names
+    try {
+        StudentQuery roster = db_manager.query_students();
+        roster.in_course(101).select(FIELD_ID | FIELD_NAME);
+        roster.for_each([](const StudentQueryRow& row) {
+            std::cout << "Course 101 (streamed): " << row.id << " " << row.name << std::endl;
+        });
+        std::cout << "Streamed " << roster.stats().lines << " lines, " << roster.stats().matched << " matches" << std::endl;
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Arena-backed load: names and course lists are bump-allocated and freed in one shot
+    StudentDataset arena_student_db;
+    try {
+        db_manager.load_dataset(arena_student_db);
+        std::cout << "Arena dataset matches parallel load: "
+                  << (arena_student_db.records().count() == parallel_student_db.count() ? "yes" : "NO") << std::endl;
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Binary snapshot backend: convert the text files and check the round trip
+    try {
+        db_manager.convert_text_to_snapshot();
+        RecordList<Student> snapshot_student_db;
+        RecordList<Course> snapshot_course_db;
+        db_manager.load_snapshot(snapshot_student_db, snapshot_course_db);
+
+        bool same = snapshot_student_db.count() == parallel_student_db.count() &&
+                    snapshot_course_db.count() == loaded_course_db.count();
+        for (size_t i = 0; same && i < snapshot_student_db.count(); ++i) {
+            same = snapshot_student_db.get_records()[i].to_string() == parallel_student_db.get_records()[i].to_string();
+        }
+        for (size_t i = 0; same && i < snapshot_course_db.count(); ++i) {
+            same = snapshot_course_db.get_records()[i].to_string() == loaded_course_db.get_records()[i].to_string();
+        }
+        std::cout << "Text -> snapshot -> memory round trip: " << (same ? "identical" : "MISMATCH") << std::endl;
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Write-ahead journal: recover, apply mutations as O(1) appends, then compact
+    try {
+        RecordList<Student> journal_student_db;
+        RecordList<Course> journal_course_db;
+        db_manager.recover(journal_student_db, journal_course_db);
+
+        db_manager.add_student(journal_student_db, Student("Carol White", 5003, 1003));
+        Student* carol = journal_student_db.find_record(5003);
+        Course* math = journal_course_db.find_record(101);
+        if (carol && math) {
+            db_manager.enroll(*carol, *math);
+        }
+        db_manager.sync_journal();
+        db_manager.compact(journal_student_db, DatabaseManager::course_pointers(journal_course_db)).get();
+
+        RecordList<Student> recovered_student_db;
+        RecordList<Course> recovered_course_db;
+        db_manager.recover(recovered_student_db, recovered_course_db);
+        std::cout << "Students after compaction and recovery: " << recovered_student_db.count() << std::endl;
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+
+    // Concurrent enrollment: two threads race for the single seat of a seminar
+    Course seminar(301, "Research Seminar", 1);
+    EnrollmentEngine engine(loaded_student_db, {&seminar});
+    std::atomic<int> seats_won(0);
+    auto try_enroll = [&](int student_id) {
+        try {
+            if (engine.enroll(student_id, 301)) seats_won++;
+        } catch (const SystemException& e) {
+            std::cerr << "ENROLLMENT ERROR (" << student_id << "): " << e.what() << std::endl;
+        }
+    };
+    std::thread first(try_enroll, 5001), second(try_enroll, 5002);
+    first.join();
+    second.join();
+    engine.publish();
+    std::cout << "Seminar seats taken by concurrent enrollment: " << seats_won << " | " << seminar << std::endl;
+
+    // Batch enrollment: one call, per-request result codes, no exceptions
+    Course workshop(302, "Compiler Workshop", 1);
+    EnrollmentEngine batch_engine(loaded_student_db, {&workshop});
+    std::vector<EnrollmentRequest> batch = {{5001, 302}, {5002, 302}, {5001, 302}, {5003, 302}, {5001, 999}};
+    std::vector<EnrollmentResult> batch_results = batch_engine.enroll_batch(batch);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        std::cout << "Batch request " << batch[i].student_id << " -> " << batch[i].course_id << ": "
+                  << enrollment_result_name(batch_results[i]) << std::endl;
+    }
+    batch_engine.publish();
+
+    // Columnar copy of the loaded students for analytics scans
+    StudentTable student_table = StudentTable::from_records(loaded_student_db);
+    for (const auto& entry : student_table.count_per_course()) {
+        std::cout << "Course " << entry.first << " has " << entry.second << " enrolled student(s)" << std::endl;
+    }
+    std::cout << "Students in both 101 and 301 (" << simd_kernels().name << " kernels):";
+    for (int id : student_table.co_enrolled(101, 301)) {
+        std::cout << " " << id;
+    }
+    std::cout << std::endl;
+    
+    // Display loaded records to confirm File I/O success
+    loaded_student_db.display_all();
+    
+    // Search demonstration
+    Student* found_s = loaded_student_db.find_record(5001);
+    if(found_s) {
+        std::cout << "Found record for ID 5001: " << found_s->get_name() << std::endl;
+    }
+
+    // Indexed mode: O(1) lookups by ID plus secondary indexes on roll number and name
+    loaded_student_db.enable_index();
+    auto* by_roll = loaded_student_db.add_index(std::make_unique<KeyIndex<Student, int>>(
+        [](const Student& s) { return s.get_roll_number(); }));
+    auto* by_name = loaded_student_db.add_index(std::make_unique<PrefixIndex<Student>>(
+        [](const Student& s) { return std::string(s.get_name()); }));
+
+    RecordList<Student>::Handle bob = loaded_student_db.get_handle(5002);
+    if (Student* s = loaded_student_db.find_by(*by_roll, 1002)) {
+        std::cout << "Found record for Roll No 1002: " << s->get_name() << std::endl;
+    }
+    for (Student* s : loaded_student_db.find_by_prefix(*by_name, "Ali")) {
+        std::cout << "Name prefix 'Ali' matches: " << s->get_name() << std::endl;
+    }
+    if (bob) {
+        std::cout << "Handle for ID 5002 resolves to: " << bob->get_name() << std::endl;
+    }
+
+    // Reverse index: rosters without scanning, kept current by enroll()/unenroll()
+    auto* rosters = loaded_student_db.add_index(std::make_unique<EnrollmentIndex>());
+    std::cout << "Course 101 roster size: " << rosters->roster_size(101) << std::endl;
+    if (Student* alice = loaded_student_db.find_record(5001)) {
+        alice->enroll(401);
+        std::cout << "Course 401 roster after enroll: " << rosters->roster_size(401) << std::endl;
+        alice->unenroll(401);
+        std::cout << "Course 401 roster after unenroll: " << rosters->roster_size(401) << std::endl;
+        for (Faculty* teacher : EnrollmentIndex::faculty_of(*alice, {&f1})) {
+            std::cout << "Alice is taught by: " << teacher->get_name() << std::endl;
+        }
+    }
+    std::cout << "Students taught by " << f1.get_name() << ": " << rosters->students_of(f1).size() << std::endl;
+    std::cout << "Reverse index consistent: " << (rosters->check_consistency(loaded_student_db) ? "yes" : "NO") << std::endl;
+    rosters->rebuild(loaded_student_db, ThreadPool::shared()); // Bulk rebuild on the work-stealing pool
+    std::cout << "Reverse index consistent after parallel rebuild: "
+              << (rosters->check_consistency(loaded_student_db) ? "yes" : "NO") << std::endl;
+
+    // Record schemas: the text line and the binary record come from the same field list
+    std::cout << "Faculty record: " << f1.to_string() << std::endl;
+    if (const Student* alice = loaded_student_db.find_record(5001)) {
+        std::string binary;
+        RecordCodec<Student>::append_binary(binary, *alice);
+        std::string_view data = binary;
+        StudentRecordView decoded;
+        if (!RecordCodec<Student>::parse_binary(data, decoded)) {
+            size_t courses = 0;
+            for_each_course_id(decoded.course_ids, [&](int) { courses++; });
+            std::cout << "Binary record: " << binary.size() << " bytes, decodes to " << decoded.name << " ("
+                      << courses << " courses)" << std::endl;
+        }
+    }
+
+    // Lazy mode: open() builds only an ID -> offset table; a student is parsed when first touched
+    try {
+        LazyStudentStore lazy(1); // Keep at most one hydrated student
+        size_t indexed = db_manager.open_lazy(lazy);
+        std::cout << "Lazy store indexed " << indexed << " student(s) ("
+                  << (lazy.opened_from_sidecar() ? "from sidecar" : "by scan") << "), hydrated: "
+                  << lazy.hydrated_count() << std::endl;
+        if (const Student* alice = lazy.find_record(5001)) {
+            std::cout << "Lazy lookup for ID 5001: " << alice->get_name() << std::endl;
+        }
+        lazy.enroll(5002, 401);
+        lazy.find_record(5001); // Evicts 5002; its change is parked as a text line
+        std::cout << "Hydrated: " << lazy.hydrated_count() << ", changed and evicted: " << lazy.parked_count()
+                  << ", 5002 now has " << lazy.find_record(5002)->course_count() << " course(s)" << std::endl;
+    } catch (const SystemException& e) {
+        std::cerr << "\n[LAZY ERROR]: " << e.what() << std::endl;
+    }
+
+    // Sharded mode: three local shard processes behind a router, course seats kept by one coordinator
+    std::cout << "\n[Sharded Mode]" << std::endl;
+    try {
+        SeatCoordinator seats(loaded_course_db);
+        LocalShardCluster cluster(3, "university.shards");
+        ShardRouter router(cluster.endpoints(), seats);
+        router.import(loaded_student_db);
+        router.reconcile_seats(); // Seat counts follow the shards' enrollments
+        std::vector<size_t> per_shard = router.counts();
+        std::cout << "Students per shard:";
+        for (size_t n : per_shard) std::cout << " " << n;
+        std::cout << std::endl;
+        if (const Course* c = loaded_course_db.find_record(101)) {
+            std::cout << "Seats in 101 after reconciling with the shards: " << c->get_enrolled_students() << "/"
+                      << c->get_capacity() << std::endl;
+        }
+        std::cout << "Enroll 5002 in 101 (shard " << router.shard_of(5002) << "): "
+                  << enrollment_result_name(router.enroll(5002, 101)) << std::endl;
+        std::cout << "Unenroll 5002 from 101: " << (router.unenroll(5002, 101) ? "done" : "not enrolled")
+                  << ", enroll again: " << enrollment_result_name(router.enroll(5002, 101)) << std::endl;
+        std::cout << "Enroll 5002 in 201: " << enrollment_result_name(router.enroll(5002, 201)) << std::endl;
+        if (std::optional<Student> alice = router.find_student(5001)) {
+            std::cout << "Shard copy of 5001: " << alice->to_string() << std::endl;
+        }
+        router.save_all();
+        std::cout << "Shard files saved under university.shards/" << std::endl;
+        router.shutdown_all();
+    } catch (const SystemException& e) {
+        std::cerr << "\n[SHARD ERROR]: " << e.what() << std::endl;
+    }
+
+#if UMS_METRICS
+    // Metrics: snapshot summary, text export for a scraper and a Chrome trace of the run
+    MetricsSnapshot metrics = Metrics::snapshot();
+    std::cout << "\n[Metrics] students loaded: " << metrics.counter(Counter::StudentsLoaded)
+              << ", corrupt lines: " << metrics.counter(Counter::CorruptLines)
+              << ", lookups: " << metrics.counter(Counter::RecordLookups)
+              << ", course 201 enrollment failure rate: " << metrics.failure_rate(201) << std::endl;
+    try {
+        Metrics::write_text("university.metrics");
+        Metrics::write_chrome_trace("university.trace.json");
+        std::cout << "[Metrics] Written to university.metrics and university.trace.json" << std::endl;
+    } catch (const SystemException& e) {
+        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    }
+#endif
+
+    // Program termination (demonstrates Destructors being called for s1, s2, f1)
+    Logger::set_level(LogLevel::Debug); // Destructor messages are debug-level
+    std::cout << "\n=== Program End: Global and stack objects are being destroyed ===" << std::endl;
+    
+    return 0;
+}
+#endif // UMS_BENCHMARK
+
+#ifdef UMS_BENCHMARK
+// =====================================================================
+// BENCHMARKS
+// Build separately: g++ -std=c++17 -O2 -pthread -DUMS_BENCHMARK main.cpp -o ums_bench
+// (see the benchmark suite section below for the JSON suite and dataset generator)
+// =====================================================================
+#include <sys/resource.h>
+
+// Counts heap allocations made through operator new (benchmark build only)
+static std::atomic<size_t> g_allocation_count(0);
+
+// (std::pmr::new_delete_resource allocates through the aligned overloads, so those are counted too)
+__attribute__((noinline)) void* operator new(size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t align) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = std::max(static_cast<size_t>(align), sizeof(void*));
+    void* p = nullptr;
+    if (posix_memalign(&p, alignment, size ? size : 1) == 0) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+// Lightweight record so the benchmark measures the container, not Student's console output
+struct BenchRecord {
+    int id;
+    int get_id() const { return id; }
+    void display_details() const {}
+};
+
+static volatile long long g_bench_sink = 0; // Keeps the measured calls from being optimized away
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Compares the original linear scan with the hash-indexed find_record()
+void benchmark_record_lookup() {
+    std::cout << "=== RecordList::find_record (scan vs. indexed) ===" << std::endl;
+    std::cout << std::setw(10) << "records" << std::setw(16) << "scan ns/op"
+              << std::setw(16) << "index ns/op" << std::setw(12) << "speedup" << std::endl;
+
+    std::mt19937 rng(42);
+    for (size_t n : {10000u, 100000u, 1000000u}) {
+        RecordList<BenchRecord> scan_list;
+        RecordList<BenchRecord> index_list;
+        index_list.enable_index();
+
+        std::vector<int> ids(n);
+        for (size_t i = 0; i < n; ++i) ids[i] = static_cast<int>(i * 7 + 100000);
+        std::shuffle(ids.begin(), ids.end(), rng);
+        for (int id : ids) {
+            scan_list.add_record(BenchRecord{id}, false);
+            index_list.add_record(BenchRecord{id}, false);
+        }
+
+        // Keep the scan's total work roughly constant across sizes
+        size_t scan_queries = std::max<size_t>(50, 200000000 / n / 100);
+        size_t index_queries = 1000000;
+        std::vector<int> queries(std::max(scan_queries, index_queries));
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        for (int& q : queries) q = ids[pick(rng)];
+
+        long long checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < scan_queries; ++i) {
+            checksum += scan_list.find_record(queries[i])->id;
+        }
+        double scan_ns = elapsed_ns(start) / scan_queries;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < index_queries; ++i) {
+            checksum += index_list.find_record(queries[i])->id;
+        }
+        double index_ns = elapsed_ns(start) / index_queries;
+
+        std::cout << std::setw(10) << n << std::setw(16) << std::fixed << std::setprecision(1) << scan_ns
+                  << std::setw(16) << index_ns << std::setw(11) << std::setprecision(0) << scan_ns / index_ns << "x"
+                  << "   (checksum " << checksum << ")" << std::endl;
+    }
+}
+
+// Discards console output while alive (Student's constructors/destructor are chatty)
+class QuietConsole {
+private:
+    std::streambuf* saved_out;
+    std::streambuf* saved_err;
+
+public:
+    QuietConsole() : saved_out(std::cout.rdbuf(nullptr)), saved_err(std::cerr.rdbuf(nullptr)) {}
+    ~QuietConsole() {
+        std::cout.rdbuf(saved_out);
+        std::cerr.rdbuf(saved_err);
+        std::cout.clear();
+        std::cerr.clear();
+    }
+};
+
+// The benchmarks never write the record files in the working directory: their
+// files go under this scratch directory (suite/generate take --dir to change it)
+std::string g_bench_prefix = "ums_bench.scratch/";
+
+inline std::string bench_path(const std::string& name) { return g_bench_prefix + name; }
+
+void make_bench_dir() {
+    std::string dir = g_bench_prefix.substr(0, g_bench_prefix.size() - 1);
+    if (!dir.empty() && ::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw SystemException("Could not create benchmark directory " + dir + ".");
+    }
+}
+
+// Writes the scratch student_records.txt with 'count' students enrolled in 1-6 courses each
+void write_bench_students(size_t count) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> course_count(1, 6), course(100, 399);
+    std::ofstream out(bench_path("student_records.txt"));
+    for (size_t i = 0; i < count; ++i) {
+        out << 100000 + i << "|Student Number " << i << "|" << 1001 + i << "|";
+        int n = course_count(rng);
+        for (int c = 0; c < n; ++c) {
+            out << (c ? "," : "") << course(rng);
+        }
+        out << "\n";
+    }
+}
+
+// Stream loader vs. memory-mapped loader vs. parallel loader
+void benchmark_student_load() {
+    const size_t count = 200000;
+    std::cout << "\n=== DatabaseManager student load (" << count << " records) ===" << std::endl;
+    write_bench_students(count);
+
+    DatabaseManager db(g_bench_prefix);
+    double stream_ms, mapped_ms, parallel_ms, snapshot_ms;
+    LoadTimings timings;
+    {
+        QuietConsole quiet;
+        RecordList<Student> list;
+        auto start = std::chrono::steady_clock::now();
+        db.load_students(list);
+        stream_ms = elapsed_ns(start) / 1e6;
+        start = std::chrono::steady_clock::now();
+        db.load_students_mapped(list);
+        mapped_ms = elapsed_ns(start) / 1e6;
+        start = std::chrono::steady_clock::now();
+        timings = db.load_students_parallel(list);
+        parallel_ms = elapsed_ns(start) / 1e6;
+
+        RecordList<Course> courses;
+        db.save_snapshot(list, {});
+        start = std::chrono::steady_clock::now();
+        db.load_snapshot(list, courses);
+        snapshot_ms = elapsed_ns(start) / 1e6;
+    }
+    std::cout << std::fixed << std::setprecision(1)
+              << "stream (getline/split/stoi): " << stream_ms << " ms" << std::endl
+              << "memory-mapped:               " << mapped_ms << " ms" << std::endl
+              << "parallel (" << timings.threads << " threads):        " << parallel_ms << " ms"
+              << "  [map " << timings.map_ms << ", parse " << timings.parse_ms << ", merge " << timings.merge_ms << "]"
+              << std::endl
+              << "binary snapshot:             " << snapshot_ms << " ms" << std::endl;
+}
+
+// Runs 'load' in a forked child so each variant starts from a fresh heap.
+// Reports the load time, operator new calls during the load and the child's peak RSS.
+template <typename LoadFn>
+void measure_load_in_child(const char* label, LoadFn load) {
+    int fds[2];
+    if (pipe(fds) != 0) throw SystemException("pipe() failed");
+    pid_t pid = fork();
+    if (pid < 0) throw SystemException("fork() failed");
+    if (pid == 0) {
+        close(fds[0]);
+        double result[2];
+        {
+            QuietConsole quiet;
+            size_t before = g_allocation_count.load();
+            auto start = std::chrono::steady_clock::now();
+            load();
+            result[0] = elapsed_ns(start) / 1e6;
+            result[1] = static_cast<double>(g_allocation_count.load() - before);
+        }
+        write_fully(fds[1], reinterpret_cast<const char*>(result), sizeof(result));
+        _exit(0);
+    }
+    close(fds[1]);
+    double result[2] = {0, 0};
+    ssize_t got = read(fds[0], reinterpret_cast<char*>(result), sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    if (got != static_cast<ssize_t>(sizeof(result))) {
+        std::cout << std::left << std::setw(28) << label << "child failed" << std::endl;
+        return;
+    }
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << result[0] << " ms" << std::setw(12) << static_cast<size_t>(result[1])
+              << " allocs" << std::setw(10) << usage.ru_maxrss / 1024 << " MB peak RSS" << std::endl;
+}
+
+// Allocation count and peak RSS of a 1M-student load: stream loader (copying
+// add_record), mapped and parallel loaders into Student, and the arena-backed dataset
+void benchmark_arena_load() {
+    const size_t count = 1000000;
+    std::cout << "\n=== Student load allocations (" << count << " records) ===" << std::endl;
+    write_bench_students(count);
+
+    DatabaseManager db(g_bench_prefix);
+    measure_load_in_child("stream (before):", [&] {
+        RecordList<Student> list;
+        db.load_students(list);
+    });
+    measure_load_in_child("mapped, default heap:", [&] {
+        RecordList<Student> list;
+        db.load_students_mapped(list);
+    });
+    measure_load_in_child("parallel, default heap:", [&] {
+        RecordList<Student> list;
+        db.load_students_parallel(list);
+    });
+    measure_load_in_child("parallel, arena dataset:", [&] {
+        StudentDataset dataset;
+        db.load_dataset(dataset);
+    });
+}
+
+// Time to first request after a restart: full parallel load vs. lazy open
+// (offset scan on the first start, sidecar afterwards), each in a fresh child.
+// The last row serves 100k lookups over a 1k-student active set from a 1024-entry cache.
+void benchmark_lazy_open() {
+    const size_t count = 1000000;
+    std::cout << "\n=== Time to first request (" << count << " records) ===" << std::endl;
+    write_bench_students(count);
+    std::remove(bench_path("student_records.txt.idx").c_str());
+
+    DatabaseManager db(g_bench_prefix);
+    const int first_request = 100000 + static_cast<int>(count / 2);
+    measure_load_in_child("full load + first find:", [&] {
+        RecordList<Student> list;
+        db.load_students_parallel(list);
+        list.enable_index();
+        g_bench_sink = list.find_record(first_request)->get_roll_number();
+    });
+    measure_load_in_child("lazy scan + first find:", [&] {
+        LazyStudentStore store(1024);
+        db.open_lazy(store);
+        g_bench_sink = store.find_record(first_request)->get_roll_number();
+    });
+    measure_load_in_child("lazy sidecar + first find:", [&] {
+        LazyStudentStore store(1024);
+        db.open_lazy(store);
+        g_bench_sink = store.find_record(first_request)->get_roll_number();
+    });
+    measure_load_in_child("lazy sidecar + 100k finds:", [&] {
+        LazyStudentStore store(1024);
+        db.open_lazy(store);
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<int> active(0, 999);
+        long long rolls = 0;
+        for (int i = 0; i < 100000; ++i) {
+            rolls += store.find_record(100000 + active(rng) * static_cast<int>(count / 1000))->get_roll_number();
+        }
+        g_bench_sink = rolls;
+    });
+}
+
+// "Who is in course 201?" by loading everything vs. by a streaming query (time and peak RSS)
+void benchmark_streaming_query() {
+    const size_t count = 1000000;
+    std::cout << "\n=== Course roster query (" << count << " records) ===" << std::endl;
+    write_bench_students(count);
+
+    DatabaseManager db(g_bench_prefix);
+    measure_load_in_child("baseline (no work):", [] {});
+    measure_load_in_child("load_students_mapped + scan:", [&] {
+        RecordList<Student> list;
+        db.load_students_mapped(list);
+        size_t matches = 0;
+        for (const Student& s : list.get_records()) matches += simd_contains(s.get_enrolled_course_ids(), 201);
+        g_bench_sink = static_cast<long long>(matches);
+    });
+    measure_load_in_child("StudentQuery in_course:", [&] {
+        StudentQuery query = db.query_students();
+        query.in_course(201).select(FIELD_ID | FIELD_NAME);
+        size_t name_bytes = 0;
+        query.for_each([&](const StudentQueryRow& row) { name_bytes += row.name.size(); });
+        g_bench_sink = static_cast<long long>(name_bytes);
+    });
+}
+
+// Course roster by scanning every student vs. the EnrollmentIndex posting list
+void benchmark_roster_index() {
+    const size_t count = 1000000;
+    std::cout << "\n=== Course roster: scan vs. EnrollmentIndex (" << count << " students) ===" << std::endl;
+    write_bench_students(count);
+
+    DatabaseManager db(g_bench_prefix);
+    RecordList<Student> students;
+    double index_build_ms, scan_ms, index_ms, enroll_ns;
+    size_t scanned = 0, indexed = 0;
+    {
+        QuietConsole quiet;
+        db.load_students_mapped(students);
+        students.enable_index();
+        auto start = std::chrono::steady_clock::now();
+        EnrollmentIndex* rosters = students.add_index(std::make_unique<EnrollmentIndex>());
+        rosters->roster_size(201); // Sorts the bulk-loaded posting list
+        index_build_ms = elapsed_ns(start) / 1e6;
+
+        const int queries = 20;
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            std::vector<int> roster;
+            for (const Student& s : students.get_records()) {
+                if (simd_contains(s.get_enrolled_course_ids(), 200 + q)) roster.push_back(s.get_id());
+            }
+            scanned += roster.size();
+        }
+        scan_ms = elapsed_ns(start) / 1e6 / queries;
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            std::vector<int> roster = rosters->roster(200 + q);
+            indexed += roster.size();
+        }
+        index_ms = elapsed_ns(start) / 1e6 / queries;
+
+        // Incremental upkeep: enroll + unenroll through Student (console messages off)
+        Logger::set_level(LogLevel::Warn);
+        std::mt19937 rng(13);
+        const int updates = 200000;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < updates; ++i) {
+            Student& s = students.get_records()[rng() % students.count()];
+            s.enroll(200 + i % 50);
+            s.unenroll(200 + i % 50);
+        }
+        enroll_ns = elapsed_ns(start) / updates;
+        Logger::set_level(LogLevel::Info);
+    }
+    std::cout << std::fixed << std::setprecision(3)
+              << "index build (bulk):     " << index_build_ms << " ms" << std::endl
+              << "roster by scan:         " << scan_ms << " ms/query (" << scanned << " rows)" << std::endl
+              << "roster by index (copy): " << index_ms << " ms/query (" << indexed << " rows)" << std::endl
+              << std::setprecision(1) << "enroll+unenroll pair:   " << enroll_ns << " ns" << std::endl;
+}
+
+// Bulk passes over a mixed population (9 students per faculty member):
+// std::vector<User*> over separately allocated objects with virtual calls,
+// vs. UserStore's contiguous arrays with static dispatch
+void benchmark_user_store() {
+    const size_t count = 1000000;
+    std::cout << "\n=== Mixed users: vector<User*> vs. UserStore (" << count << " users) ===" << std::endl;
+
+    std::vector<Course> courses;
+    for (int c = 0; c < 8; ++c) courses.emplace_back(100 + c, "Course", 1000);
+    std::vector<std::unique_ptr<User>> owned; // The current layout: one heap object per user
+    std::vector<User*> users;
+    UserStore store;
+    {
+        QuietConsole quiet;
+        Logger::set_level(LogLevel::Warn);
+        // Each layout is built in its own pass, the way its own code would build it
+        auto make_faculty = [&](size_t i) {
+            Faculty f("User " + std::to_string(i), static_cast<int>(i), "Dept");
+            for (size_t c = 0; c < i % 3; ++c) f.assign_course(&courses[c]);
+            return f;
+        };
+        auto make_student = [&](size_t i) {
+            Student s("User " + std::to_string(i), static_cast<int>(i), 1);
+            for (size_t c = 0; c < i % 5; ++c) s.enroll(100 + static_cast<int>(c));
+            return s;
+        };
+        owned.reserve(count);
+        users.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (i % 10 == 9) {
+                owned.push_back(std::make_unique<Faculty>(make_faculty(i)));
+            } else {
+                owned.push_back(std::make_unique<Student>(make_student(i)));
+            }
+            users.push_back(owned.back().get());
+        }
+        store.reserve(count - count / 10, count / 10);
+        for (size_t i = 0; i < count; ++i) {
+            if (i % 10 == 9) {
+                store.add(make_faculty(i));
+            } else {
+                store.add(make_student(i));
+            }
+        }
+        Logger::set_level(LogLevel::Info);
+    }
+
+    auto best_of = [](int runs, auto&& fn) {
+        double best = 1e30;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            best = std::min(best, elapsed_ns(start) / 1e6);
+        }
+        return best;
+    };
 
-        std::string line;
-        while (std::getline(infile, line)) {
-            if (line.empty()) continue;
+    std::string text;
+    text.reserve(64 * count);
+    size_t pointer_bytes = 0, store_bytes = 0, pointer_count = 0, store_count = 0, pointer_hits = 0, store_hits = 0;
+    double pointer_export = best_of(5, [&] {
+        text.clear();
+        for (const User* u : users) {
+            u->append_record(text);
+            text += '\n';
+        }
+        pointer_bytes = text.size();
+    });
+    double store_export = best_of(5, [&] {
+        text.clear();
+        store.export_text(text);
+        store_bytes = text.size();
+    });
 
-            try {
-                std::vector<std::string> parts = split(line, '|');
-                if (parts.size() < 3) continue;
+    double pointer_counting = best_of(5, [&] {
+        pointer_count = 0;
+        for (const User* u : users) pointer_count += u->course_count() >= 2 ? 1 : 0;
+    });
+    double store_counting = best_of(5, [&] {
+        store_count = store.count_if([](const auto& user) { return user.course_count() >= 2; });
+    });
+
+    auto matches = [](const auto& user) { return user.course_count() > 0 && user.get_name().substr(0, 6) == "User 1"; };
+    double pointer_filter = best_of(5, [&] {
+        std::vector<int> ids;
+        for (const User* u : users) {
+            if (u->course_count() > 0 && u->get_name().substr(0, 6) == "User 1") ids.push_back(u->get_id());
+        }
+        pointer_hits = ids.size();
+    });
+    double store_filter = best_of(5, [&] { store_hits = store.filter_ids(matches).size(); });
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "export:    vector<User*> " << pointer_export << " ms | UserStore " << store_export << " ms ("
+              << pointer_export / store_export << "x, " << (pointer_bytes == store_bytes ? "same bytes" : "SIZE MISMATCH") << ")\n"
+              << "counting:  vector<User*> " << pointer_counting << " ms | UserStore " << store_counting << " ms ("
+              << pointer_counting / store_counting << "x, " << (pointer_count == store_count ? "same" : "MISMATCH") << ")\n"
+              << "filtering: vector<User*> " << pointer_filter << " ms | UserStore " << store_filter << " ms ("
+              << pointer_filter / store_filter << "x, " << (pointer_hits == store_hits ? "same" : "MISMATCH") << ")" << std::endl;
+
+    QuietConsole quiet; // Destructors log at debug level only, but keep teardown off the report
+    owned.clear();
+}
+
+// Work-stealing pool scaling on embarrassingly parallel per-student work
+// (format each record and checksum the text), plus a parallel index rebuild.
+// Thread counts above the machine's hardware threads are skipped.
+void benchmark_parallel_scaling() {
+    const size_t count = 1000000;
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\n=== Work-stealing pool scaling (" << count << " students, " << hardware
+              << " hardware threads) ===" << std::endl;
+
+    RecordList<Student> students;
+    {
+        QuietConsole quiet;
+        Logger::set_level(LogLevel::Warn);
+        students.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Student s("Student " + std::to_string(i), static_cast<int>(i), 1);
+            for (int c = 0; c < 4; ++c) s.enroll(100 + static_cast<int>((i * 7 + c * 13) % 300));
+            students.add_record(std::move(s), false);
+        }
+        Logger::set_level(LogLevel::Info);
+    }
+    EnrollmentIndex* rosters = students.add_index(std::make_unique<EnrollmentIndex>());
+
+    auto per_student = [](const Student& s) {
+        thread_local std::string text;
+        text.clear();
+        RecordCodec<Student>::append_text(text, s);
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (int round = 0; round < 8; ++round) {
+            for (char c : text) hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        g_bench_sink = g_bench_sink + static_cast<long long>(hash & 1);
+    };
+
+    double serial_ms = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (const Student& s : students.get_records()) per_student(s);
+        serial_ms = std::min(serial_ms, elapsed_ns(start) / 1e6);
+    }
+    std::cout << std::fixed << std::setprecision(1) << "plain loop (no pool): " << serial_ms << " ms" << std::endl;
+
+    double base_ms = 0, base_rebuild_ms = 0;
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(14) << "per-student" << std::setw(10) << "speedup"
+              << std::setw(12) << "efficiency" << std::setw(14) << "index rebuild" << "speedup" << std::endl;
+    for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u}) {
+        if (threads > hardware) break;
+        ThreadPool pool(threads);
+        students.parallel_for_each(pool, per_student); // Warm-up (thread_local buffers, caches)
+        double best_ms = 1e30, best_rebuild_ms = 1e30;
+        for (int run = 0; run < 3; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            students.parallel_for_each(pool, per_student);
+            best_ms = std::min(best_ms, elapsed_ns(start) / 1e6);
+            start = std::chrono::steady_clock::now();
+            rosters->rebuild(students, pool);
+            best_rebuild_ms = std::min(best_rebuild_ms, elapsed_ns(start) / 1e6);
+        }
+        if (threads == 1) {
+            base_ms = best_ms;
+            base_rebuild_ms = best_rebuild_ms;
+        }
+        std::cout << std::fixed << std::setprecision(1) << std::setw(10) << threads << std::setw(14)
+                  << (std::to_string(static_cast<long long>(best_ms)) + " ms") << std::setw(10) << base_ms / best_ms
+                  << std::setw(12) << (std::to_string(static_cast<int>(100 * base_ms / best_ms / threads)) + "%")
+                  << std::setw(14) << (std::to_string(static_cast<long long>(best_rebuild_ms)) + " ms")
+                  << base_rebuild_ms / best_rebuild_ms << std::endl;
+    }
+    std::cout << std::right << "Rebuilt index consistent: " << (rosters->check_consistency(students) ? "yes" : "NO")
+              << std::endl;
+}
+
+// Blocking save vs. save_async(): how long the caller is held up, and how much
+// foreground enrollment work gets done while the pipeline writes the files
+void benchmark_async_save() {
+    const size_t count = 1000000;
+    std::cout << "\n=== Save: blocking vs. save_async (" << count << " students) ===" << std::endl;
+    write_bench_students(count);
+
+    DatabaseManager db(g_bench_prefix);
+    RecordList<Student> students;
+    RecordList<Course> courses;
+    double sync_ms, capture_ms, total_ms;
+    size_t foreground_enrolls = 0;
+    {
+        QuietConsole quiet;
+        Logger::set_level(LogLevel::Warn);
+        db.load_students_mapped(students);
+        for (int id = 100; id < 400; ++id) courses.add_record(Course(id, "Course " + std::to_string(id), 1000000), false);
+        std::vector<Course*> course_list = DatabaseManager::course_pointers(courses);
+
+        auto start = std::chrono::steady_clock::now();
+        db.save_students(students);
+        db.save_courses(course_list);
+        sync_ms = elapsed_ns(start) / 1e6;
+
+        start = std::chrono::steady_clock::now();
+        std::future<void> saved = db.save_async(students, course_list);
+        capture_ms = elapsed_ns(start) / 1e6;
+        while (saved.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            students.get_records()[foreground_enrolls % count].enroll(400 + static_cast<int>(foreground_enrolls % 8));
+            foreground_enrolls++;
+        }
+        saved.get();
+        total_ms = elapsed_ns(start) / 1e6;
+        Logger::set_level(LogLevel::Info);
+    }
+    std::cout << std::fixed << std::setprecision(1)
+              << "save_students + save_courses: " << sync_ms << " ms (caller blocked throughout)" << std::endl
+              << "save_async, caller blocked:   " << capture_ms << " ms (copying the records)" << std::endl
+              << "save_async, until complete:   " << total_ms << " ms, " << foreground_enrolls
+              << " foreground enrolls meanwhile" << std::endl;
+}
 
-                int id = std::stoi(parts[0]);
-                std::string name = parts[1];
-                int roll = std::stoi(parts[2]);
+// Many threads hammer a small course through EnrollmentEngine; the seat count
+// must end exactly at capacity and no student may hold the course twice
+bool benchmark_enrollment_stress() {
+    const int thread_count = 8;
+    std::cout << "\n=== EnrollmentEngine stress (" << thread_count << " threads, enroll() and enroll_batch()) ===" << std::endl;
 
-                // Constructor that takes roll number for loading
-                Student s(name, id, roll);
+    // Every thread tries every student, starting at a different offset. Odd
+    // threads use enroll_batch() in chunks of 64, even threads enroll().
+    auto run = [&](const char* label, int capacity, int student_count) {
+        std::atomic<int> enrolled(0), already(0), full(0);
+        int seats = 0, holders = 0;
+        double ms;
+        {
+            QuietConsole quiet;
+            RecordList<Student> students;
+            for (int i = 0; i < student_count; ++i) {
+                students.add_record(Student("Stress " + std::to_string(i), 1000000 + i, 1), false);
+            }
+            Course course(999, "Stress Course", capacity);
+            EnrollmentEngine engine(students, {&course});
 
-                // Load enrolled courses
-                if (parts.size() > 3 && !parts[3].empty()) {
-                    std::vector<std::string> course_ids = split(parts[3], ',');
-                    for (const std::string& cid_str : course_ids) {
-                        s.enroll(std::stoi(cid_str)); // Uses Function Overloading
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int t = 0; t < thread_count; ++t) {
+                threads.emplace_back([&, t] {
+                    std::vector<EnrollmentRequest> batch;
+                    for (int i = 0; i < student_count; ++i) {
+                        int id = 1000000 + (i * 7 + t * 613) % student_count;
+                        if (t % 2) {
+                            batch.push_back(EnrollmentRequest{id, 999});
+                            if (batch.size() < 64 && i + 1 < student_count) continue;
+                            for (EnrollmentResult r : engine.enroll_batch(batch)) {
+                                (r == EnrollmentResult::Enrolled ? enrolled : r == EnrollmentResult::CourseFull ? full : already)++;
+                            }
+                            batch.clear();
+                            continue;
+                        }
+                        try {
+                            (engine.enroll(id, 999) ? enrolled : already)++;
+                        } catch (const SystemException&) {
+                            full++;
+                        }
                     }
+                });
+            }
+            for (std::thread& t : threads) t.join();
+            ms = elapsed_ns(start) / 1e6;
+
+            engine.publish();
+            seats = course.get_enrolled_students();
+            for (const Student& s : students.get_records()) {
+                holders += static_cast<int>(s.to_string().find("|999") != std::string::npos);
+            }
+        }
+        int expected = std::min(capacity, student_count);
+        // With room for everyone, any "full" answer would be a spurious one
+        bool ok = enrolled == expected && seats == expected && holders == expected &&
+                  (capacity < student_count || full == 0);
+        std::cout << label << thread_count * student_count << " attempts in " << std::fixed << std::setprecision(1) << ms
+                  << " ms | enrolled " << enrolled << ", already " << already << ", full " << full << " | seats "
+                  << seats << "/" << capacity << " | " << (ok ? "OK" : "INVARIANT VIOLATED") << std::endl;
+        return ok;
+    };
+    bool ok = run("oversubscribed: ", 64, 5000);
+    ok = run("exact fit:      ", 512, 512) && ok;
+
+    // Two threads enroll the same pair into a course that is already full.
+    // Both must be told it is full; an "already enrolled" answer (or a
+    // membership left behind) means a duplicate saw a pair that had no seat.
+    // In odd rounds the second thread goes through enroll_batch().
+    const int rounds = 2000;
+    int wrong = 0, seats = 0;
+    {
+        QuietConsole quiet;
+        RecordList<Student> students;
+        for (int i = 0; i <= rounds; ++i) {
+            students.add_record(Student("Duplicate " + std::to_string(i), 1000000 + i, 1), false);
+        }
+        Course course(998, "Full Course", 1);
+        EnrollmentEngine engine(students, {&course});
+        engine.enroll(1000000, 998); // Takes the only seat
+        for (int round = 1; round <= rounds; ++round) {
+            int id = 1000000 + round;
+            std::atomic<int> ready(0);
+            bool told_full[2] = {false, false};
+            auto attempt = [&](int side) {
+                ready++;
+                while (ready.load() < 2) std::this_thread::yield();
+                if (side == 1 && round % 2) {
+                    told_full[side] = engine.enroll_batch({EnrollmentRequest{id, 998}})[0] == EnrollmentResult::CourseFull;
+                    return;
                 }
-                student_list.add_record(s, false); // Add loaded student to list
-            } catch (const std::invalid_argument& e) {
-                // MODULE 5: Exception Handling (Catching conversion errors)
-                std::cerr << "[DB ERROR] Corrupt data line skipped: " << line << " (" << e.what() << ")" << std::endl;
+                try {
+                    engine.enroll(id, 998);
+                } catch (const SystemException&) {
+                    told_full[side] = true;
+                }
+            };
+            std::thread first(attempt, 0), second(attempt, 1);
+            first.join();
+            second.join();
+            wrong += !told_full[0] || !told_full[1] || engine.is_enrolled(id, 998);
+        }
+        seats = course.get_enrolled_students();
+    }
+    bool duplicates_ok = wrong == 0 && seats == 1;
+    std::cout << "duplicate pair, full course: " << rounds << " rounds | wrong answers " << wrong << " | seats " << seats
+              << "/1 | " << (duplicates_ok ? "OK" : "INVARIANT VIOLATED") << std::endl;
+    return ok && duplicates_ok;
+}
+
+// Cross-shard stress: router threads enroll (and sometimes unenroll) students
+// spread over shard processes, in oversubscribed courses. The seat lease is
+// 1 ms and another thread keeps expiring leases, so many shard replies arrive
+// after their reservation was given back. Afterwards every course's seat count
+// must equal its enrollments summed over the shards, within capacity.
+bool benchmark_shard_enrollment_stress() {
+    const int shard_count = 4, thread_count = 8, student_count = 10000, course_count = 40, capacity = 150;
+    std::cout << "\n=== Cross-shard enrollment stress (" << shard_count << " shards, " << student_count << " students, "
+              << thread_count << " router threads) ===" << std::endl;
+
+    std::atomic<int> enrolled(0), full(0), already(0), unenrolled(0), errors(0);
+    std::atomic<size_t> expired(0);
+    std::atomic<bool> done(false);
+    RecordList<Course> courses;
+    for (int c = 0; c < course_count; ++c) courses.emplace_record(700 + c, "Shard Stress " + std::to_string(c), capacity);
+    courses.enable_index();
+    size_t unresolved = 0, open_reservations = 0;
+    bool recounted_ok = true; // Seat counts before reconcile_seats() matched the shards
+    std::unordered_map<int, int> on_shards;
+    double ms = 0;
+    try {
+        QuietConsole quiet;
+        RecordList<Student> students;
+        for (int i = 0; i < student_count; ++i) {
+            students.add_record(Student("Shard Stress " + std::to_string(i), 2000000 + i, 1), false);
+        }
+        SeatCoordinator seats(courses, std::chrono::milliseconds(1));
+        for (int k = 0; k < shard_count; ++k) { // Shards recover their files: start from empty ones
+            for (const char* file : {"university.snapshot", "university.journal"}) {
+                std::remove((ShardMap::file_prefix(bench_path("shards"), k) + file).c_str());
             }
         }
-        infile.close();
-        std::cout << "[DB] Student records loaded successfully. Total: " << student_list.count() << std::endl;
+        LocalShardCluster cluster(shard_count, bench_path("shards"));
+        ShardRouter router(cluster.endpoints(), seats);
+        router.import(students);
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread expirer([&] {
+            while (!done) {
+                expired += seats.expire_stale();
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = t; i < student_count; i += thread_count) {
+                    int id = 2000000 + i;
+                    for (int k = 0; k < 4; ++k) {
+                        int course_id = 700 + (i * 7 + k * 13) % course_count;
+                        try {
+                            EnrollmentResult r = router.enroll(id, course_id);
+                            (r == EnrollmentResult::Enrolled ? enrolled : r == EnrollmentResult::CourseFull ? full : already)++;
+                            if (k == 1 && r == EnrollmentResult::Enrolled && router.unenroll(id, course_id)) unenrolled++;
+                        } catch (const SystemException&) {
+                            errors++;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& t : threads) t.join();
+        done = true;
+        expirer.join();
+        ms = elapsed_ns(start) / 1e6;
+
+        unresolved = router.resolve_in_doubt();
+        open_reservations = seats.pending_count();
+        on_shards = router.course_enrollments();
+        for (const Course& course : courses.get_records()) {
+            recounted_ok = recounted_ok && course.get_enrolled_students() == on_shards[course.get_id()];
+        }
+        router.reconcile_seats(); // A recount from the shards must not change anything
+        router.shutdown_all();
+    } catch (const SystemException& e) {
+        done = true;
+        std::cerr << "[BENCH ERROR]: " << e.what() << std::endl;
+        return false;
     }
-    
-    // Simple course saving (for demonstration)
-    void save_courses(const std::vector<Course*>& course_list) {
-        std::ofstream outfile(COURSE_FILE); 
-        if (!outfile.is_open()) {
-            throw SystemException("Could not open course file for writing.");
+
+    bool ok = errors == 0 && unresolved == 0 && open_reservations == 0 && recounted_ok;
+    for (const Course& course : courses.get_records()) {
+        int seated = course.get_enrolled_students();
+        ok = ok && seated == on_shards[course.get_id()] && seated <= capacity;
+    }
+    std::cout << thread_count * (student_count / thread_count) * 4 << " enrollments in " << std::fixed << std::setprecision(1)
+              << ms << " ms | enrolled " << enrolled << ", full " << full << ", already " << already << ", unenrolled "
+              << unenrolled << ", errors " << errors << " | expired leases " << expired << " | seats "
+              << (ok ? "match the shard enrollments: OK" : "differ from the shard enrollments: INVARIANT VIOLATED")
+              << std::endl;
+    return ok;
+}
+
+// Per-request Student::enroll vs. EnrollmentEngine::enroll_batch on the same workload
+void benchmark_batch_enrollment() {
+    const int student_count = 20000, course_count = 200, request_count = 100000;
+    std::cout << "\n=== Batch enrollment (" << request_count << " requests, " << course_count << " courses) ===" << std::endl;
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> pick_student(0, student_count - 1), pick_course(0, course_count - 1);
+    std::vector<EnrollmentRequest> requests(request_count);
+    for (EnrollmentRequest& r : requests) r = EnrollmentRequest{100000 + pick_student(rng), 500 + pick_course(rng)};
+
+    double single_ms, batch_ms;
+    size_t single_enrolled = 0, batch_enrolled = 0;
+    {
+        QuietConsole quiet;
+        RecordList<Student> students;
+        students.enable_index();
+        for (int i = 0; i < student_count; ++i) {
+            students.add_record(Student("Batch " + std::to_string(i), 100000 + i, 1), false);
         }
+        RecordList<Course> courses;
+        courses.enable_index();
+        for (int c = 0; c < course_count; ++c) courses.add_record(Course(500 + c, "Course", 400), false);
 
-        for (const Course* c : course_list) {
-            outfile << c->to_string() << "\n";
+        // Copies for the batch run, so both start from the same state
+        RecordList<Student> batch_students;
+        for (const Student& s : students.get_records()) batch_students.add_record(s, false);
+        RecordList<Course> batch_courses;
+        for (const Course& c : courses.get_records()) batch_courses.add_record(c, false);
+
+        auto start = std::chrono::steady_clock::now();
+        for (const EnrollmentRequest& r : requests) {
+            students.find_record(r.student_id)->enroll(*courses.find_record(r.course_id));
         }
-        outfile.close();
-        std::cout << "[DB] Course records saved successfully." << std::endl;
+        single_ms = elapsed_ns(start) / 1e6;
+        for (const Course& c : courses.get_records()) single_enrolled += static_cast<size_t>(c.get_enrolled_students());
+
+        EnrollmentEngine engine(batch_students, DatabaseManager::course_pointers(batch_courses));
+        start = std::chrono::steady_clock::now();
+        std::vector<EnrollmentResult> results = engine.enroll_batch(requests);
+        batch_ms = elapsed_ns(start) / 1e6;
+        batch_enrolled = static_cast<size_t>(std::count(results.begin(), results.end(), EnrollmentResult::Enrolled));
+    }
+    std::cout << std::fixed << std::setprecision(1)
+              << "Student::enroll loop: " << single_ms << " ms (" << single_enrolled << " enrolled)" << std::endl
+              << "enroll_batch:         " << batch_ms << " ms (" << batch_enrolled << " enrolled)" << std::endl;
+}
+
+// Per-course enrollment counting: RecordList<Student> (objects) vs. StudentTable (columns)
+void benchmark_course_counting() {
+    const size_t count = 1000000;
+    std::cout << "\n=== Per-course enrollment count (" << count << " students) ===" << std::endl;
+
+    double object_ms, column_ms, convert_ms;
+    size_t object_total = 0, column_total = 0;
+    {
+        QuietConsole quiet;
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> course_count(1, 6), course(100, 399);
+        RecordList<Student> students;
+        students.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Student s("Student " + std::to_string(i), static_cast<int>(i), 1);
+            for (int c = course_count(rng); c > 0; --c) s.enroll(course(rng));
+            students.add_record(s, false);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<size_t> counts(400, 0);
+        for (const Student& s : students.get_records()) {
+            for (int course_id : s.get_enrolled_course_ids()) counts[static_cast<size_t>(course_id)]++;
+        }
+        object_ms = elapsed_ns(start) / 1e6;
+        for (size_t c : counts) object_total += c;
+
+        start = std::chrono::steady_clock::now();
+        StudentTable table = StudentTable::from_records(students);
+        convert_ms = elapsed_ns(start) / 1e6;
+
+        start = std::chrono::steady_clock::now();
+        std::vector<std::pair<int, size_t>> per_course = table.count_per_course();
+        column_ms = elapsed_ns(start) / 1e6;
+        for (const auto& entry : per_course) column_total += entry.second;
+    }
+    std::cout << std::fixed << std::setprecision(2)
+              << "RecordList<Student> scan: " << object_ms << " ms (" << object_total << " enrollments)" << std::endl
+              << "StudentTable scan:        " << column_ms << " ms (" << column_total << " enrollments)" << std::endl
+              << "one-off conversion:       " << convert_ms << " ms" << std::endl;
+}
+
+// SIMD kernels vs. the std::find / std::set_intersection / scalar counting paths
+void benchmark_simd_kernels() {
+    std::cout << "\n=== SIMD kernels (" << simd_kernels().name << ") ===" << std::endl;
+    std::mt19937 rng(9);
+    long long sink = 0;
+
+    for (size_t length : {6u, 64u}) {
+        const size_t lists = 100000, probes = 4000000;
+        std::uniform_int_distribution<int> course(100, 999);
+        std::vector<int> values(lists * length);
+        for (int& v : values) v = course(rng);
+        std::vector<int> needles(probes);
+        for (int& v : needles) v = course(rng);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t p = 0; p < probes; ++p) {
+            const int* list = values.data() + (p % lists) * length;
+            sink += std::find(list, list + length, needles[p]) != list + length;
+        }
+        double find_ns = elapsed_ns(start) / probes;
+
+        const SimdKernels& kernels = simd_kernels();
+        start = std::chrono::steady_clock::now();
+        for (size_t p = 0; p < probes; ++p) {
+            sink += kernels.contains(values.data() + (p % lists) * length, length, needles[p]);
+        }
+        double simd_ns = elapsed_ns(start) / probes;
+        std::cout << std::fixed << std::setprecision(2) << "contains, list of " << std::setw(2) << length
+                  << ": std::find " << find_ns << " ns, simd " << simd_ns << " ns" << std::endl;
+    }
+
+    {
+        // Two rosters of 200k sorted student IDs with ~50% overlap
+        std::vector<int> a, b;
+        for (int id = 0; a.size() < 200000; ++id) {
+            if (rng() % 2) a.push_back(id);
+            if (rng() % 2) b.push_back(id);
+        }
+        std::vector<int> out(a.size());
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < 20; ++r) sink += std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), out.begin()) - out.begin();
+        double scalar_ms = elapsed_ns(start) / 1e6 / 20;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < 20; ++r) sink += static_cast<long long>(simd_intersect_sorted(a.data(), a.size(), b.data(), b.size(), out.data()));
+        double simd_ms = elapsed_ns(start) / 1e6 / 20;
+        std::cout << "intersect 200k x 200k: std::set_intersection " << scalar_ms << " ms, simd " << simd_ms << " ms" << std::endl;
     }
-};
+
+    {
+        std::uniform_int_distribution<int> course(100, 399);
+        std::vector<int> ids(4000000);
+        for (int& v : ids) v = course(rng);
+        auto start = std::chrono::steady_clock::now();
+        auto range = std::minmax_element(ids.begin(), ids.end());
+        std::vector<size_t> counts(static_cast<size_t>(*range.second - *range.first) + 1, 0);
+        for (int v : ids) counts[static_cast<size_t>(v - *range.first)]++;
+        double scalar_ms = elapsed_ns(start) / 1e6;
+        sink += static_cast<long long>(counts[0]);
+        start = std::chrono::steady_clock::now();
+        sink += static_cast<long long>(simd_histogram(ids.data(), ids.size()).size());
+        double simd_ms = elapsed_ns(start) / 1e6;
+        std::cout << "histogram of 4M course IDs: scalar " << scalar_ms << " ms, simd " << simd_ms << " ms" << std::endl;
+    }
+    std::cout << "(checksum " << sink << ")" << std::endl;
+}
 
 // =====================================================================
-// MAIN FUNCTION (Demonstration of all concepts)
+// Reproducible Benchmark Suite (JSON output)
+//   ums_bench generate [options]   writes student_records.txt / course_records.txt under --dir
+//   ums_bench suite [options]      generates the dataset, runs the suite, prints JSON
+//   ums_bench                      the human-readable reports above
+// Options: --students N --courses N --min-courses N --max-courses N
+//          --dist uniform|zipf --zipf-s S --seed N --repeat N --ops N --out FILE
+//          --dir DIR (default ums_bench.scratch; "--dir ." writes the working directory's files)
+// The generator uses its own PRNG and integer mapping (not <random>'s
+// distributions, which differ between standard libraries), so the same
+// seed writes byte-identical files on every platform.
 // =====================================================================
-int main() {
-    std::cout << "=== University Management System (RTU Syllabus Project) ===" << std::endl;
-    std::cout << "Demonstrating C++ OOP concepts from Classes/Objects to File Handling." << std::endl;
-    std::cout << "----------------------------------------------------------------" << std::endl;
+enum class Distribution { Uniform, Zipfian };
 
-    // --- MODULE 1, 4, 5: Classes, Objects, Static, Operator Overloading, Exceptions ---
-    std::cout << "\n[Module 1/4/5: Course and Objects]" << std::endl;
+struct DatasetSpec {
+    size_t students = 100000;
+    int courses = 300;
+    int min_courses = 1; // Per student
+    int max_courses = 6;
+    Distribution distribution = Distribution::Uniform;
+    double zipf_s = 0.99; // Skew of the Zipfian course popularity
+    uint64_t seed = 42;
+};
 
-    // Creation of Course Objects (demonstrates Constructor)
-    Course math_c(101, "Advanced Mathematics", 40);
-    Course cs_c(201, "Data Structures & Algos"); // Uses default argument for capacity (30)
+// splitmix64: tiny, fast and identical everywhere
+class DatasetRng {
+private:
+    uint64_t state;
 
-    // Demonstrates Operator Overloading (<<) and Static Member Function
-    std::cout << cs_c << std::endl;
-    std::cout << "Total Courses Created (Static): " << Course::get_total_courses() << std::endl;
-    
-    // Use an Array/Vector of Pointers to Course objects (for easier management)
-    std::vector<Course*> available_courses;
-    available_courses.push_back(&math_c);
-    available_courses.push_back(&cs_c);
+public:
+    explicit DatasetRng(uint64_t seed) : state(seed) {}
 
-    // Demonstrate Exception Handling (Attempting to enroll in a full course)
-    try {
-        for (int i = 0; i < 30; ++i) {
-            cs_c.increment_enrollment();
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, n)
+    uint32_t below(uint32_t n) { return static_cast<uint32_t>(((next() >> 32) * n) >> 32); }
+
+    // Uniform in [0, 1)
+    double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Picks ranks 0..n-1, uniformly or with P(rank) proportional to 1 / (rank + 1)^s
+class RankPicker {
+private:
+    Distribution distribution;
+    uint32_t n;
+    std::vector<double> cdf; // Zipfian only
+
+public:
+    RankPicker(Distribution dist, uint32_t count, double s) : distribution(dist), n(count) {
+        if (distribution == Distribution::Zipfian) {
+            cdf.resize(n);
+            double total = 0;
+            for (uint32_t r = 0; r < n; ++r) cdf[r] = (total += 1.0 / std::pow(r + 1.0, s));
+            for (double& c : cdf) c /= total;
         }
-        // FIX: Accessing private member via public getter function
-        std::cout << "[Test] Current CS enrollment: " << cs_c.get_enrolled_students() << std::endl;
-        
-        // This will throw the exception defined in Course::increment_enrollment()
-        cs_c.increment_enrollment(); 
-    } catch (const SystemException& e) {
-        // Catch block demonstrates Module 5 requirement
-        std::cerr << "\n[EXCEPTION CAUGHT]: " << e.what() << std::endl;
-    } catch (const std::exception& e) {
-        std::cerr << "Standard Exception: " << e.what() << std::endl;
     }
-    std::cout << "----------------------------------------------------------------" << std::endl;
 
-    // --- MODULE 3, 4: Inheritance, Polymorphism, Dynamic Binding, Abstract Class ---
-    std::cout << "\n[Module 3/4: Inheritance, Polymorphism & Abstract Class]" << std::endl;
+    uint32_t pick(DatasetRng& rng) const {
+        if (distribution == Distribution::Uniform) return rng.below(n);
+        size_t rank = std::upper_bound(cdf.begin(), cdf.end(), rng.unit()) - cdf.begin();
+        return static_cast<uint32_t>(std::min<size_t>(rank, n - 1));
+    }
+};
 
-    // Creation of Derived Objects
-    Student s1("Alice Smith", 5001); // Uses Static Member to assign Roll No 1001
-    Student s2("Bob Johnson", 5002); // Uses Static Member to assign Roll No 1002
-    Faculty f1("Dr. Chen", 7001, "Computer Science");
-    
-    // Demonstrate Static Member Function of Student
-    std::cout << "Total Students Created (Static): " << Student::get_total_students() << std::endl;
-    
-    // Polymorphism and Dynamic Binding demonstration (using User* pointers)
-    std::vector<User*> users;
-    users.push_back(&s1);
-    users.push_back(&f1);
+const int GENERATED_FIRST_STUDENT_ID = 100000;
+const int GENERATED_FIRST_COURSE_ID = 100;
 
-    for (const auto& user_ptr : users) {
-        // Calls the correct display_details() based on the actual object type (Dynamic Binding)
-        user_ptr->display_details();
+// Writes both record files. Course enrollment counts match the student file and
+// every course has 25% spare capacity (at least 10 seats).
+void generate_dataset(const DatasetSpec& spec) {
+    static const char* const first_names[] = {"Alice", "Bob", "Carol", "David", "Eve", "Frank", "Grace", "Heidi",
+                                              "Ivan", "Judy", "Mallory", "Niaj", "Olivia", "Peggy", "Rupert", "Sybil"};
+    static const char* const last_names[] = {"Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller",
+                                             "Davis", "Martinez", "Lopez", "Wilson", "Anderson", "Thomas", "Moore"};
+    if (spec.courses <= 0 || spec.min_courses < 0 || spec.max_courses < spec.min_courses ||
+        spec.max_courses > spec.courses) {
+        throw SystemException("Invalid dataset spec: need 0 <= min-courses <= max-courses <= courses.");
     }
-    std::cout << "----------------------------------------------------------------" << std::endl;
 
-    // --- MODULE 2: Function Overloading, Reference, Friend Class ---
-    std::cout << "\n[Module 2: Overloading, Enrollment & Friend Class Setup]" << std::endl;
+    DatasetRng rng(spec.seed);
+    RankPicker course_picker(spec.distribution, static_cast<uint32_t>(spec.courses), spec.zipf_s);
+    std::vector<int> enrolled(static_cast<size_t>(spec.courses), 0);
+    std::vector<int> picked;
 
-    // Demonstrate Function Overloading
-    s1.enroll(101);         // Calls enroll(int)
-    s2.enroll(math_c);      // Calls enroll(const Course&), demonstrating reference usage
-    s2.enroll(cs_c);        // Demonstrates the enrollment system (might catch the 'full' exception)
-    
-    f1.assign_course(&math_c); // Dynamic Memory Usage (Pointer to Course)
-    
-    // --- MODULE 5: Template Class and File Handling ---
-    std::cout << "\n[Module 5: Template & File Handling]" << std::endl;
+    std::string buffer;
+    FILE* out = std::fopen(bench_path("student_records.txt").c_str(), "wb");
+    if (!out) throw SystemException("Could not open student file for writing.");
+    for (size_t i = 0; i < spec.students; ++i) {
+        buffer += std::to_string(GENERATED_FIRST_STUDENT_ID + i);
+        buffer += '|';
+        buffer += first_names[rng.below(16)];
+        buffer += ' ';
+        buffer += last_names[rng.below(14)];
+        buffer += '|';
+        buffer += std::to_string(1001 + i);
+        buffer += '|';
 
-    // Demonstrates Template Class
-    RecordList<Student> student_db;
-    student_db.add_record(s1);
-    student_db.add_record(s2);
-    
-    DatabaseManager db_manager;
-    
-    // Demonstrates File Handling (Writing to file)
-    try {
-        db_manager.save_students(student_db); // Uses Friend Class access to save private Student data
-        db_manager.save_courses(available_courses);
-    } catch (const SystemException& e) {
-        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+        uint32_t span = static_cast<uint32_t>(spec.max_courses - spec.min_courses + 1);
+        size_t count = static_cast<size_t>(spec.min_courses) + rng.below(span);
+        picked.clear();
+        while (picked.size() < count) {
+            int rank = static_cast<int>(course_picker.pick(rng));
+            if (std::find(picked.begin(), picked.end(), rank) != picked.end()) continue;
+            picked.push_back(rank);
+            enrolled[static_cast<size_t>(rank)]++;
+            if (picked.size() > 1) buffer += ',';
+            buffer += std::to_string(GENERATED_FIRST_COURSE_ID + rank);
+        }
+        buffer += '\n';
+        if (buffer.size() > (1 << 20)) {
+            std::fwrite(buffer.data(), 1, buffer.size(), out);
+            buffer.clear();
+        }
     }
-    
-    // --- Post-Save/Load Demonstration ---
-    std::cout << "\n--- DEMONSTRATING LOAD (New DB object created) ---" << std::endl;
-    RecordList<Student> loaded_student_db;
-    
-    // Demonstrates File Handling (Reading from file)
-    try {
-        db_manager.load_students(loaded_student_db);
-    } catch (const SystemException& e) {
-        std::cerr << "\n[FILE ERROR]: " << e.what() << std::endl;
+    std::fwrite(buffer.data(), 1, buffer.size(), out);
+    std::fclose(out);
+
+    std::ofstream courses(bench_path("course_records.txt"), std::ios::binary);
+    for (int rank = 0; rank < spec.courses; ++rank) {
+        int count = enrolled[static_cast<size_t>(rank)];
+        courses << GENERATED_FIRST_COURSE_ID + rank << "|Generated Course " << rank << "|"
+                << std::max(10, count + count / 4) << "|" << count << "\n";
     }
-    
-    // Display loaded records to confirm File I/O success
-    loaded_student_db.display_all();
-    
-    // Search demonstration
-    Student* found_s = loaded_student_db.find_record(5001);
-    if(found_s) {
-        std::cout << "Found record for ID 5001: " << found_s->get_name() << std::endl;
+    if (!courses) throw SystemException("Could not write course file.");
+}
+
+// Latency samples (ns per operation) of one benchmark case
+struct BenchCase {
+    std::string name;
+    size_t ops_per_sample = 1;
+    std::vector<double> samples;
+
+    double percentile(double p) const {
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+        return sorted[std::min(sorted.size() - 1, rank ? rank - 1 : 0)];
     }
 
-    // Program termination (demonstrates Destructors being called for s1, s2, f1)
-    std::cout << "\n=== Program End: Global and stack objects are being destroyed ===" << std::endl;
-    
-    return 0;
-}
\ No newline at end of file
+    double mean() const {
+        double total = 0;
+        for (double s : samples) total += s;
+        return total / samples.size();
+    }
+};
+
+static std::string json_escape(std::string_view text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) continue;
+        out += c;
+    }
+    return out;
+}
+
+void write_json_report(std::ostream& out, const DatasetSpec& spec, int repeat, const std::vector<BenchCase>& cases) {
+    out << std::setprecision(6) << std::defaultfloat;
+    out << "{\n  \"schema\": \"ums-bench/1\",\n"
+        << "  \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(
+                                      std::chrono::system_clock::now().time_since_epoch()).count() << ",\n"
+        << "  \"compiler\": \"" << json_escape(__VERSION__) << "\",\n"
+        << "  \"simd\": \"" << simd_kernels().name << "\",\n"
+        << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"dataset\": {\"students\": " << spec.students << ", \"courses\": " << spec.courses
+        << ", \"min_courses\": " << spec.min_courses << ", \"max_courses\": " << spec.max_courses
+        << ", \"distribution\": \"" << (spec.distribution == Distribution::Zipfian ? "zipf" : "uniform")
+        << "\", \"zipf_s\": " << spec.zipf_s << ", \"seed\": " << spec.seed << "},\n"
+        << "  \"repeat\": " << repeat << ",\n  \"results\": [";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const BenchCase& c = cases[i];
+        double mean = c.mean();
+        out << (i ? "," : "") << "\n    {\"name\": \"" << json_escape(c.name) << "\", \"unit\": \"ns/op\""
+            << ", \"ops_per_sample\": " << c.ops_per_sample << ", \"samples\": " << c.samples.size()
+            << ", \"mean\": " << mean << ", \"p50\": " << c.percentile(50) << ", \"p90\": " << c.percentile(90)
+            << ", \"p99\": " << c.percentile(99) << ", \"max\": " << c.percentile(100)
+            << ", \"throughput_ops_per_s\": " << (mean > 0 ? 1e9 / mean : 0) << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Times 'total_ops' calls of op(i) in samples of 'batch' operations each
+template <typename Op>
+BenchCase run_batched(const std::string& name, size_t total_ops, size_t batch, Op op) {
+    BenchCase result;
+    result.name = name;
+    result.ops_per_sample = batch;
+    result.samples.reserve(total_ops / batch);
+    for (size_t done = 0; done + batch <= total_ops; done += batch) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = done; i < done + batch; ++i) op(i);
+        result.samples.push_back(elapsed_ns(start) / batch);
+    }
+    return result;
+}
+
+// Times 'repeat' runs of a whole-file operation over 'records' records
+template <typename Op>
+BenchCase run_repeated(const std::string& name, int repeat, size_t records, Op op) {
+    BenchCase result;
+    result.name = name;
+    result.ops_per_sample = records;
+    for (int r = 0; r < repeat; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        op();
+        result.samples.push_back(elapsed_ns(start) / std::max<size_t>(records, 1));
+    }
+    return result;
+}
+
+std::vector<BenchCase> run_suite(const DatasetSpec& spec, int repeat, size_t ops) {
+    const size_t batch = 64;
+    std::vector<BenchCase> cases;
+    generate_dataset(spec);
+
+    DatabaseManager db(g_bench_prefix);
+    RecordList<Student> students;
+    RecordList<Course> courses;
+    DatasetRng rng(spec.seed ^ 0x5EED);
+    RankPicker student_picker(spec.distribution, static_cast<uint32_t>(spec.students), spec.zipf_s);
+    RankPicker course_picker(spec.distribution, static_cast<uint32_t>(spec.courses), spec.zipf_s);
+
+    cases.push_back(run_repeated("DatabaseManager::load_students", repeat, spec.students, [&] {
+        db.load_students(students);
+    }));
+    db.load_courses(courses);
+    std::vector<Course*> course_list = DatabaseManager::course_pointers(courses);
+    cases.push_back(run_repeated("DatabaseManager::save_students", repeat, students.count(), [&] {
+        db.save_students(students);
+    }));
+    cases.push_back(run_repeated("DatabaseManager::save_courses", repeat, course_list.size(), [&] {
+        db.save_courses(course_list);
+    }));
+
+    // Lookups follow the dataset's distribution (hot students under Zipfian)
+    std::vector<int> keys(ops);
+    for (int& key : keys) key = GENERATED_FIRST_STUDENT_ID + static_cast<int>(student_picker.pick(rng));
+    long long sink = 0;
+    students.enable_index();
+    cases.push_back(run_batched("RecordList::find_record (indexed)", ops, batch, [&](size_t i) {
+        sink += students.find_record(keys[i]) != nullptr;
+    }));
+    RecordList<Student> scan_list;
+    scan_list.reserve(students.count());
+    for (const Student& s : students.get_records()) scan_list.add_record(s, false);
+    // Scans are O(n): cap the work at ~2e7 record visits and time small batches
+    size_t scan_ops = std::max(size_t(256), std::min(ops, size_t(20000000) / std::max<size_t>(spec.students, 1)));
+    cases.push_back(run_batched("RecordList::find_record (linear scan)", scan_ops, 4, [&](size_t i) {
+        sink += scan_list.find_record(keys[i]) != nullptr;
+    }));
+
+    // Fresh students, each receiving max_courses enroll attempts (duplicates included)
+    size_t per_student = static_cast<size_t>(std::max(spec.max_courses, 1));
+    std::vector<Student> fresh;
+    fresh.reserve(ops / per_student + 1);
+    for (size_t i = 0; i <= ops / per_student; ++i) {
+        fresh.emplace_back("Bench Student", static_cast<int>(i), 1);
+    }
+    std::vector<int> course_ids(ops);
+    for (int& id : course_ids) id = GENERATED_FIRST_COURSE_ID + static_cast<int>(course_picker.pick(rng));
+    cases.push_back(run_batched("Student::enroll(int)", ops, batch, [&](size_t i) {
+        fresh[i / per_student].enroll(course_ids[i]);
+    }));
+
+    Course open_course(1, "Bench Open", static_cast<int>(std::min<size_t>(ops + 1, 2000000000)));
+    cases.push_back(run_batched("Course::increment_enrollment", ops, batch, [&](size_t) {
+        open_course.increment_enrollment();
+    }));
+    Course full_course(2, "Bench Full", 0);
+    cases.push_back(run_batched("Course::increment_enrollment (full, throws)", std::min(ops, size_t(100000)), batch,
+                                [&](size_t) {
+        try {
+            full_course.increment_enrollment();
+        } catch (const SystemException&) {
+            sink++;
+        }
+    }));
+    g_bench_sink = sink;
+    return cases;
+}
+
+// Parses the suite/generate options; returns false on a bad argument
+bool parse_bench_options(int argc, char* argv[], int first, DatasetSpec& spec, int& repeat, size_t& ops,
+                         std::string& out_file) {
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        try {
+            if (arg == "--students") spec.students = std::stoull(value);
+            else if (arg == "--courses") spec.courses = std::stoi(value);
+            else if (arg == "--min-courses") spec.min_courses = std::stoi(value);
+            else if (arg == "--max-courses") spec.max_courses = std::stoi(value);
+            else if (arg == "--zipf-s") spec.zipf_s = std::stod(value);
+            else if (arg == "--seed") spec.seed = std::stoull(value);
+            else if (arg == "--repeat") repeat = std::max(1, std::stoi(value));
+            else if (arg == "--ops") ops = std::max<size_t>(64, std::stoull(value));
+            else if (arg == "--out") out_file = value;
+            else if (arg == "--dir" && !value.empty()) g_bench_prefix = value + "/";
+            else if (arg == "--dist" && (value == "uniform" || value == "zipf")) {
+                spec.distribution = value == "zipf" ? Distribution::Zipfian : Distribution::Uniform;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "shard" && argc == 4) return run_shard_process(argv[2], argv[3]); // Started by LocalShardCluster
+    if (command == "suite" || command == "generate") {
+        DatasetSpec spec;
+        int repeat = 5;
+        size_t ops = 1000000;
+        std::string out_file;
+        if (!parse_bench_options(argc, argv, 2, spec, repeat, ops, out_file)) {
+            std::cerr << "usage: " << argv[0] << " [suite|generate] [--students N] [--courses N] [--min-courses N]"
+                      << " [--max-courses N] [--dist uniform|zipf] [--zipf-s S] [--seed N] [--repeat N] [--ops N]"
+                      << " [--out FILE] [--dir DIR]" << std::endl;
+            return 2;
+        }
+        try {
+            make_bench_dir();
+            if (command == "generate") {
+                generate_dataset(spec);
+                return 0;
+            }
+            Logger::set_level(LogLevel::Warn); // Measure the data path, not per-call console output
+            std::vector<BenchCase> cases;
+            {
+                QuietConsole quiet;
+                cases = run_suite(spec, repeat, ops);
+            }
+            if (out_file.empty()) {
+                write_json_report(std::cout, spec, repeat, cases);
+            } else {
+                std::ofstream out(out_file);
+                write_json_report(out, spec, repeat, cases);
+            }
+        } catch (const SystemException& e) {
+            std::cerr << "[BENCH ERROR]: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    try {
+        make_bench_dir();
+    } catch (const SystemException& e) {
+        std::cerr << "[BENCH ERROR]: " << e.what() << std::endl;
+        return 1;
+    }
+    benchmark_record_lookup();
+    benchmark_student_load();
+    benchmark_arena_load();
+    benchmark_streaming_query();
+    benchmark_lazy_open();
+    benchmark_roster_index();
+    benchmark_async_save();
+    benchmark_parallel_scaling();
+    benchmark_user_store();
+    bool ok = benchmark_enrollment_stress();
+    ok = benchmark_shard_enrollment_stress() && ok;
+    benchmark_batch_enrollment();
+    benchmark_course_counting();
+    benchmark_simd_kernels();
+    if (!ok) std::cerr << "[BENCH ERROR]: a stress check found an invariant violation." << std::endl;
+    return ok ? 0 : 1;
+}
+#endif // UMS_BENCHMARK